@@ -1,11 +1,689 @@
 #include <iostream>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+// The AVX2 kernel is only built with GCC-compatible compilers on x86,
+// it is selected at runtime if the CPU supports it
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_AVX2_KERNEL 1
+#include <immintrin.h>
+#endif
+
+// Precomputed tables are stored in files and mapped in memory
+// on POSIX systems
+#if defined(__unix__) || defined(__APPLE__)
+#define HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 // Input range
 #define MIN_NUM 0
 #define MAX_NUM 10000
 
-int main()
+// Cycle lengths are cached for all starting values up to this bound
+// (it can be raised with --max, e.g. up to 10^8)
+#define CACHE_BOUND MAX_NUM
+
+// Number of starting values per chunk in the parallel precomputation
+#define CHUNK_SIZE 65536
+
+// Number of starting values advanced by a kernel call
+#define BATCH_SIZE 1024
+
+// Number of starting values per block in the range-maximum index
+#define BLOCK_SIZE 64
+
+// Identification of table files (--table)
+// The version has to be increased whenever the layout changes
+#define TABLE_MAGIC "3NP1TAB"
+#define TABLE_VERSION 1
+
+// Cycle lengths stay below 1000 for starting values up to 10^8,
+// thus 2 bytes are enough
+using Length = std::uint16_t;
+
+// Numbers generated in a cycle can be much larger than
+// the initial number, 8 bytes are used for them
+using Value = std::uint64_t;
+
+// Compute cycle length of `start`
+// `cache` stores the lengths already known for values up to `bound`
+// (0 indicates the length has not yet been computed)
+// Lengths of intermediate values met on the path are also stored
+// `path` is only a buffer, reused between calls to avoid allocations
+Length cycle_length(
+    const Value start,
+    Length * cache,
+    const Value bound,
+    std::vector<Value> & path
+) {
+    // Generate numbers until one with known length is reached
+    // (cache[1] is always known)
+    path.clear();
+    Value n = start;
+    for (;;) {
+        if (n <= bound && cache[n] != 0)
+            break;
+
+        path.push_back(n);
+
+        // Compute next number in the cycle
+        if (n % 2 == 0)
+            n = n / 2;
+        else
+            n = 3 * n + 1;
+    }
+
+    // Go back over the path, each number adds one to the length
+    Length length = cache[n];
+    for (std::size_t i = path.size(); i > 0; --i) {
+        ++length;
+
+        const Value value = path[i - 1];
+        if (value <= bound)
+            cache[value] = length;
+    }
+
+    return length;
+}
+
+// Range-maximum index over the cycle lengths of [1, bound]
+// Lengths are split in blocks of BLOCK_SIZE values:
+//  - a sparse table over the block maxima answers the whole blocks
+//  - the partial blocks at both ends are scanned (at most 2 * BLOCK_SIZE values)
+// Thus any query is answered in constant time, whatever its width
+// Its arrays are stored in the table image (see TableLayout)
+struct RangeMaxIndex {
+    // Number of blocks and levels
+    std::size_t n_blocks;
+    std::size_t n_levels;
+
+    // Sparse table, levels stored one after another
+    // table[l * n_blocks + b] is the maximum of blocks b to b + 2^l - 1
+    Length * table;
+
+    // log_2[c] is the largest level l with 2^l <= c
+    std::uint8_t * log_2;
+};
+
+// Build index over lengths[1] to lengths[bound]
+// (all of them have to be already computed)
+void build_index(
+    const Length * lengths,
+    const std::size_t bound,
+    RangeMaxIndex & index
+) {
+    const std::size_t n_blocks = index.n_blocks;
+    const std::size_t n_levels = index.n_levels;
+
+    index.log_2[0] = 0;
+    index.log_2[1] = 0;
+    for (std::size_t c = 2; c <= n_blocks; ++c)
+        index.log_2[c] = index.log_2[c / 2] + 1;
+
+    std::fill(index.table, index.table + n_levels * n_blocks, 0);
+
+    // Level 0 stores the maximum of each block
+    for (std::size_t i = 1; i <= bound; ++i) {
+        Length & block_max = index.table[i / BLOCK_SIZE];
+        if (lengths[i] > block_max)
+            block_max = lengths[i];
+    }
+
+    // Each level combines two halves from the previous one
+    for (std::size_t l = 1; l < n_levels; ++l) {
+        const Length * previous = index.table + (l - 1) * n_blocks;
+        Length * current = index.table + l * n_blocks;
+        const std::size_t half = std::size_t(1) << (l - 1);
+
+        for (std::size_t b = 0; b + 2 * half <= n_blocks; ++b)
+            current[b] = std::max(previous[b], previous[b + half]);
+    }
+}
+
+// Maximum of lengths[lo] to lengths[hi], with 1 <= lo <= hi <= bound
+Length query_max(
+    const Length * lengths,
+    const RangeMaxIndex & index,
+    const std::size_t lo,
+    const std::size_t hi
+) {
+    const std::size_t block_lo = lo / BLOCK_SIZE;
+    const std::size_t block_hi = hi / BLOCK_SIZE;
+
+    Length max = 0;
+
+    // Range inside a single block is scanned
+    if (block_lo == block_hi) {
+        for (std::size_t i = lo; i <= hi; ++i)
+            max = std::max(max, lengths[i]);
+
+        return max;
+    }
+
+    // Partial blocks at both ends
+    for (std::size_t i = lo; i < (block_lo + 1) * BLOCK_SIZE; ++i)
+        max = std::max(max, lengths[i]);
+
+    for (std::size_t i = block_hi * BLOCK_SIZE; i <= hi; ++i)
+        max = std::max(max, lengths[i]);
+
+    // Whole blocks in between are covered by two
+    // (possibly overlapping) entries of the sparse table
+    if (block_lo + 1 < block_hi) {
+        const std::size_t first = block_lo + 1;
+        const std::size_t count = block_hi - first;
+        const std::size_t l = index.log_2[count];
+        const Length * level = index.table + l * index.n_blocks;
+
+        max = std::max(max, level[first]);
+        max = std::max(max, level[block_hi - (std::size_t(1) << l)]);
+    }
+
+    return max;
+}
+
+// Header of a table image
+struct TableHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t block_size;
+    std::uint64_t bound;
+    std::uint64_t size;
+};
+
+// Position of each array in a table image:
+//  header | lengths[0..bound] | sparse table | log_2
+// Each array starts at a multiple of 64 bytes
+// The same image is built in memory and stored in table files
+struct TableLayout {
+    std::size_t n_blocks;
+    std::size_t n_levels;
+    std::size_t lengths_offset;
+    std::size_t table_offset;
+    std::size_t log_2_offset;
+    std::size_t size;
+};
+
+// Round up to a multiple of 64 bytes
+std::size_t align_64(const std::size_t offset) {
+    return (offset + 63) / 64 * 64;
+}
+
+TableLayout table_layout(const std::size_t bound) {
+    TableLayout layout;
+
+    // Block b covers values b * BLOCK_SIZE to (b + 1) * BLOCK_SIZE - 1
+    layout.n_blocks = bound / BLOCK_SIZE + 1;
+
+    layout.n_levels = 1;
+    while ((std::size_t(2) << (layout.n_levels - 1)) <= layout.n_blocks)
+        ++layout.n_levels;
+
+    layout.lengths_offset = align_64(sizeof(TableHeader));
+    layout.table_offset = align_64(layout.lengths_offset + (bound + 1) * sizeof(Length));
+    layout.log_2_offset = align_64(layout.table_offset + layout.n_levels * layout.n_blocks * sizeof(Length));
+    layout.size = align_64(layout.log_2_offset + layout.n_blocks + 1);
+
+    return layout;
+}
+
+// Lengths and range-maximum index, pointing to a table image
+struct CycleTable {
+    std::size_t bound;
+    Length * lengths;
+    RangeMaxIndex index;
+};
+
+// Point table arrays to an image with the given layout
+void attach_table(
+    char * image,
+    const std::size_t bound,
+    const TableLayout & layout,
+    CycleTable & table
+) {
+    table.bound = bound;
+    table.lengths = reinterpret_cast<Length *>(image + layout.lengths_offset);
+    table.index.n_blocks = layout.n_blocks;
+    table.index.n_levels = layout.n_levels;
+    table.index.table = reinterpret_cast<Length *>(image + layout.table_offset);
+    table.index.log_2 = reinterpret_cast<std::uint8_t *>(image + layout.log_2_offset);
+}
+
+#ifdef HAVE_MMAP
+// Map a table file built for `bound`
+// Returns false if the file is missing or stale
+// (different magic, version, block size, bound or size)
+// The mapping is private, so the file is never modified,
+// and it is kept until the process ends
+bool map_table(
+    const std::string & path,
+    const std::size_t bound,
+    CycleTable & table
+) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    const TableLayout layout = table_layout(bound);
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) != layout.size) {
+        close(fd);
+        return false;
+    }
+
+    void * mapping = mmap(nullptr, layout.size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED)
+        return false;
+
+    const TableHeader * header = static_cast<const TableHeader *>(mapping);
+    if (std::strncmp(header->magic, TABLE_MAGIC, sizeof(header->magic)) != 0
+        || header->version != TABLE_VERSION
+        || header->block_size != BLOCK_SIZE
+        || header->bound != bound
+        || header->size != layout.size) {
+        munmap(mapping, layout.size);
+        return false;
+    }
+
+    attach_table(static_cast<char *>(mapping), bound, layout, table);
+    return true;
+}
+
+// Write a table image to `path`
+// It is written to a temporary file first, which then replaces `path`,
+// so other processes never map a partially written table
+bool write_table(
+    const std::string & path,
+    const char * image,
+    const std::size_t size
+) {
+    const std::string temporary = path + ".tmp." + std::to_string(getpid());
+
+    const int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+
+    std::size_t written = 0;
+    while (written < size) {
+        const ssize_t n = write(fd, image + written, size - written);
+        if (n <= 0)
+            break;
+
+        written += n;
+    }
+
+    const bool is_written = written == size && fsync(fd) == 0;
+    if (close(fd) != 0 || !is_written || rename(temporary.c_str(), path.c_str()) != 0) {
+        unlink(temporary.c_str());
+        return false;
+    }
+
+    return true;
+}
+#endif
+
+// Kernels advancing the cycles of starting values first to last - 1
+// until each number drops below its starting value
+// (first has to be at least 2)
+// steps[i - first] receives the number of steps done
+// and rest[i - first] the number reached
+using StepKernel = void (*)(Value first, Value last, Length * steps, Value * rest);
+
+// Only starting values i = 3 (mod 4) need to follow the cycle:
+//  - even i drops after one step: i / 2
+//  - i = 1 (mod 4) drops after three steps: (3 * i + 1) / 4
+void advance_short(const Value i, Length & steps, Value & rest) {
+    if (i % 2 == 0) {
+        steps = 1;
+        rest = i / 2;
+    }
+    else {
+        steps = 3;
+        rest = (3 * i + 1) / 4;
+    }
+}
+
+void advance_scalar(
+    const Value first,
+    const Value last,
+    Length * steps,
+    Value * rest
+) {
+    for (Value i = first; i < last; ++i) {
+        if (i % 4 != 3) {
+            advance_short(i, steps[i - first], rest[i - first]);
+            continue;
+        }
+
+        Value n = i;
+        Length count = 0;
+
+        while (n >= i) {
+            if (n % 2 == 0)
+                n = n / 2;
+            else
+                n = 3 * n + 1;
+
+            ++count;
+        }
+
+        steps[i - first] = count;
+        rest[i - first] = n;
+    }
+}
+
+#ifdef HAVE_AVX2_KERNEL
+// Starting values i = 3 (mod 4) are advanced in lockstep, four at a time
+// Each iteration computes both n / 2 and (3 * n + 1) / 2
+// (an odd step is always followed by an even one)
+// and selects them without branches
+// Lanes already below their starting value are kept as they are
+__attribute__((target("avx2")))
+void advance_avx2(
+    const Value first,
+    const Value last,
+    Length * steps,
+    Value * rest
+) {
+    // First starting value = 3 (mod 4)
+    const Value first_long = first + (3 - first % 4);
+
+    for (Value i = first; i < last; ++i) {
+        if (i % 4 != 3)
+            advance_short(i, steps[i - first], rest[i - first]);
+    }
+
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m256i two = _mm256_set1_epi64x(2);
+
+    // Numbers stay below 2^63, so signed comparisons are valid
+    Value i = first_long;
+    for (; i + 12 < last; i += 16) {
+        const __m256i start = _mm256_set_epi64x(i + 12, i + 8, i + 4, i);
+        __m256i n = start;
+        __m256i count = _mm256_setzero_si256();
+
+        // Lanes still above their starting value
+        __m256i active = _mm256_set1_epi64x(-1);
+
+        for (;;) {
+            const __m256i is_odd = _mm256_cmpeq_epi64(_mm256_and_si256(n, one), one);
+            const __m256i half = _mm256_srli_epi64(n, 1);
+            const __m256i triple_half = _mm256_add_epi64(_mm256_add_epi64(n, half), one);
+
+            const __m256i next = _mm256_blendv_epi8(half, triple_half, is_odd);
+            const __m256i added = _mm256_blendv_epi8(one, two, is_odd);
+
+            n = _mm256_blendv_epi8(n, next, active);
+            count = _mm256_add_epi64(count, _mm256_and_si256(added, active));
+
+            active = _mm256_andnot_si256(_mm256_cmpgt_epi64(start, n), active);
+            if (_mm256_testz_si256(active, active))
+                break;
+        }
+
+        alignas(32) std::int64_t lane_n[4];
+        alignas(32) std::int64_t lane_count[4];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lane_n), n);
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lane_count), count);
+
+        for (int l = 0; l < 4; ++l) {
+            steps[i + 4 * l - first] = lane_count[l];
+            rest[i + 4 * l - first] = lane_n[l];
+        }
+    }
+
+    // Remaining starting values (fewer than four)
+    for (; i < last; i += 4)
+        advance_scalar(i, i + 1, steps + (i - first), rest + (i - first));
+}
+#endif
+
+// Choose the kernel supported by the CPU
+StepKernel select_kernel() {
+#ifdef HAVE_AVX2_KERNEL
+    if (__builtin_cpu_supports("avx2"))
+        return advance_avx2;
+#endif
+
+    return advance_scalar;
+}
+
+// Chunks of starting values owned by a thread
+// Other threads steal chunks from it once their own ones are finished
+struct ChunkQueue {
+    // Next chunk to be taken
+    std::atomic<std::size_t> next;
+
+    // End of the chunks owned by the thread
+    std::size_t end;
+};
+
+// Compute lengths[1] to lengths[bound] using n_threads threads
+// Starting values are advanced in batches by the fastest kernel available
+// Chain lengths are very uneven, so chunks are first split evenly
+// between threads and then stolen from the busiest ones
+// Lengths are only read from chunks already finished
+// (or from the own chunk), thus no thread waits for another
+void compute_lengths(
+    Length * lengths,
+    const std::size_t bound,
+    const unsigned n_threads
+) {
+    const std::size_t n_chunks = bound / CHUNK_SIZE + 1;
+
+    // Flags indicating the lengths in a chunk are all written
+    std::vector<std::atomic<bool>> chunk_done(n_chunks);
+    for (std::size_t c = 0; c < n_chunks; ++c)
+        chunk_done[c].store(false);
+
+    // Contiguous ranges of chunks for each thread
+    std::vector<ChunkQueue> queues(n_threads);
+    for (unsigned t = 0; t < n_threads; ++t) {
+        queues[t].next.store(n_chunks * t / n_threads);
+        queues[t].end = n_chunks * (t + 1) / n_threads;
+    }
+
+    const StepKernel advance = select_kernel();
+
+    // Fill lengths of a single chunk
+    const auto compute_chunk = [&](const std::size_t c) {
+        const Value chunk_begin = c * CHUNK_SIZE;
+        const Value chunk_end = std::min<Value>(chunk_begin + CHUNK_SIZE, bound + 1);
+
+        // 1 is the end of every cycle
+        Value batch_begin = std::max<Value>(chunk_begin, 2);
+        if (chunk_begin <= 1 && chunk_end > 1)
+            lengths[1] = 1;
+
+        Length steps[BATCH_SIZE];
+        Value rest[BATCH_SIZE];
+
+        while (batch_begin < chunk_end) {
+            const Value batch_end = std::min<Value>(batch_begin + BATCH_SIZE, chunk_end);
+
+            // Numbers are advanced until they drop below their starting value
+            advance(batch_begin, batch_end, steps, rest);
+
+            for (Value i = batch_begin; i < batch_end; ++i) {
+                Value n = rest[i - batch_begin];
+                Length length = steps[i - batch_begin];
+
+                // Values below i are known if they are in this chunk
+                // or in a finished one
+                // Otherwise the cycle is followed until one of them is found
+                for (;;) {
+                    if (n == 1) {
+                        length += 1;
+                        break;
+                    }
+
+                    if (n < i) {
+                        if (n >= chunk_begin || chunk_done[n / CHUNK_SIZE].load(std::memory_order_acquire)) {
+                            length += lengths[n];
+                            break;
+                        }
+                    }
+
+                    // Compute next number in the cycle
+                    if (n % 2 == 0)
+                        n = n / 2;
+                    else
+                        n = 3 * n + 1;
+
+                    ++length;
+                }
+
+                lengths[i] = length;
+            }
+
+            batch_begin = batch_end;
+        }
+
+        chunk_done[c].store(true, std::memory_order_release);
+    };
+
+    // Per-thread statistics
+    std::vector<std::size_t> n_own(n_threads, 0);
+    std::vector<std::size_t> n_stolen(n_threads, 0);
+    std::vector<double> elapsed_ms(n_threads, 0.0);
+
+    const auto work = [&](const unsigned t) {
+        const auto start = std::chrono::steady_clock::now();
+
+        // Own chunks first, then the ones of the other threads
+        for (unsigned k = 0; k < n_threads; ++k) {
+            ChunkQueue & queue = queues[(t + k) % n_threads];
+
+            for (;;) {
+                const std::size_t c = queue.next.fetch_add(1);
+                if (c >= queue.end)
+                    break;
+
+                compute_chunk(c);
+
+                if (k == 0)
+                    ++n_own[t];
+                else
+                    ++n_stolen[t];
+            }
+        }
+
+        const auto stop = std::chrono::steady_clock::now();
+        elapsed_ms[t] = std::chrono::duration<double, std::milli>(stop - start).count();
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < n_threads; ++t)
+        threads.emplace_back(work, t);
+
+    work(0);
+
+    for (std::thread & thread : threads)
+        thread.join();
+
+    // Report timing
+    if (n_threads > 1) {
+        for (unsigned t = 0; t < n_threads; ++t)
+            std::cerr << "thread " << t << ": "
+                      << n_own[t] + n_stolen[t] << " chunks ("
+                      << n_stolen[t] << " stolen), "
+                      << elapsed_ms[t] << " ms\n";
+    }
+}
+
+int main(int argc, char * argv[])
 {
+    // Options:
+    //  --max N      precompute and index lengths up to N (default MAX_NUM)
+    //  --threads T  precompute with T threads (0 uses all cores)
+    //  --table PATH map precomputed lengths and index from PATH,
+    //               or build them and store them there if the file
+    //               is missing or was built for another bound or version
+    std::size_t bound = CACHE_BOUND;
+    unsigned n_threads = 1;
+    std::string table_path;
+
+    for (int a = 1; a < argc; ++a) {
+        const std::string option = argv[a];
+
+        if (option == "--max" && a + 1 < argc) {
+            bound = std::stoull(argv[++a]);
+        }
+        else if (option == "--threads" && a + 1 < argc) {
+            n_threads = std::stoul(argv[++a]);
+            if (n_threads == 0)
+                n_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        else if (option == "--table" && a + 1 < argc) {
+            table_path = argv[++a];
+        }
+        else {
+            std::cerr << "Unknown option: " << option << "\n";
+            return 1;
+        }
+    }
+
+    // Cycle lengths of [1, bound] (kept between input lines)
+    // and range-maximum index over them
+    CycleTable table;
+    bool is_mapped = false;
+
+#ifdef HAVE_MMAP
+    if (!table_path.empty())
+        is_mapped = map_table(table_path, bound, table);
+#else
+    if (!table_path.empty())
+        std::cerr << "Table files are not supported on this system\n";
+#endif
+
+    // Memory image of the table, if it is not mapped
+    // (64-bit elements keep it aligned for all arrays)
+    std::vector<std::uint64_t> image;
+
+    if (!is_mapped) {
+        const TableLayout layout = table_layout(bound);
+        image.assign(layout.size / sizeof(std::uint64_t), 0);
+        char * base = reinterpret_cast<char *>(image.data());
+
+        TableHeader header = {};
+        std::strncpy(header.magic, TABLE_MAGIC, sizeof(header.magic));
+        header.version = TABLE_VERSION;
+        header.block_size = BLOCK_SIZE;
+        header.bound = bound;
+        header.size = layout.size;
+        std::memcpy(base, &header, sizeof(header));
+
+        attach_table(base, bound, layout, table);
+
+        // Compute all lengths in [1, bound] once
+        // and build the range-maximum index over them
+        // (0 has no cycle, its length is left as 0)
+        compute_lengths(table.lengths, bound, n_threads);
+        build_index(table.lengths, bound, table.index);
+
+#ifdef HAVE_MMAP
+        if (!table_path.empty() && !write_table(table_path, base, layout.size))
+            std::cerr << "Could not write table file: " << table_path << "\n";
+#endif
+    }
+
+    // Buffer for the numbers generated in a cycle
+    std::vector<Value> path;
+
     // Read input
     // Number of lines is unknown
     for (;;) {
@@ -36,29 +714,22 @@ int main()
         // Maximum cycle-length computed
         // There is always at least the initial number
         int max = 1;
-        for (int i = n_ini; i <= n_end; ++i) {
-            // For each i, compute cycle
-            int n = i;
 
-            // Count numbers generated in the cycle
-            int count = 0;
-            for (;;) {
-                // Update counter
-                ++count;
-
-                // Stop when 1 is reached
-                if (n == 1) {
-                    // Update maximum if needed
-                    if (count > max)
-                        max = count;
-                    break;
-                }
+        // Lines inside the indexed range are answered by the index
+        if (n_ini >= 1 && static_cast<std::size_t>(n_end) <= bound) {
+            const int count = query_max(table.lengths, table.index, n_ini, n_end);
 
-                // Compute next number in the cycle
-                if (n % 2 == 0)
-                    n = n / 2;
-                else
-                    n = 3 * n + 1;                  
+            if (count > max)
+                max = count;
+        }
+        else {
+            // Otherwise lengths are computed (and cached) one by one
+            for (int i = n_ini; i <= n_end; ++i) {
+                const int count = cycle_length(i, table.lengths, bound, path);
+
+                // Update maximum if needed
+                if (count > max)
+                    max = count;
             }
         }
 
@@ -1,149 +1,738 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <utility>
+
+// Output is written with write(2) on POSIX systems
+#if defined(__unix__) || defined(__APPLE__)
+#define HAVE_WRITE 1
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Link value for `no block`
+#define NONE -1
+
+// Size of the buffer used to read input
+#define BUFFER_SIZE 65536
+
+// Number of records written at once to a command log
+#define LOG_BATCH 8192
+
+// Identification of command log files
+#define LOG_MAGIC "BLKLOG1"
+
+// Maximum number of bytes per write call
+#define WRITE_CHUNK (1 << 24)
+
+// World of blocks stored as intrusive linked stacks
+// Moving a block (and the blocks above it) is a splice of links,
+// no block is copied
+//
+// Stack s is either empty or has block s at its bottom:
+// blocks only enter stack s by being put on top of its blocks
+// or, for block s itself, by returning to its original position
+// Thus the stack containing a block is the block at the bottom of its stack
+//
+// To find that bottom without walking the stack, each stack is also
+// a splay tree in stack order (blocks below on the left, above on the right)
+// Cutting and putting piles are splits and joins of these trees,
+// and the bottom is the leftmost block of the tree,
+// all in amortized O(log n)
+struct World {
+    // Blocks directly below and above each block
+    std::vector<int> below;
+    std::vector<int> above;
+
+    // Block at the top of each stack (NONE if empty)
+    std::vector<int> top;
+
+    // Children and parent of each block in the tree of its stack
+    // (NONE if missing)
+    std::vector<int> left;
+    std::vector<int> right;
+    std::vector<int> parent;
+};
+
+// Move block one level up in its tree, keeping the order
+void rotate(const int block, World & world) {
+    const int p = world.parent[block];
+    const int g = world.parent[p];
+
+    if (world.left[p] == block) {
+        const int moved = world.right[block];
+        world.left[p] = moved;
+        if (moved != NONE)
+            world.parent[moved] = p;
+        world.right[block] = p;
+    } else {
+        const int moved = world.left[block];
+        world.right[p] = moved;
+        if (moved != NONE)
+            world.parent[moved] = p;
+        world.left[block] = p;
+    }
+
+    world.parent[p] = block;
+    world.parent[block] = g;
+
+    if (g != NONE) {
+        if (world.left[g] == p)
+            world.left[g] = block;
+        else
+            world.right[g] = block;
+    }
+}
+
+// Move block to the root of its tree
+void splay(const int block, World & world) {
+    while (world.parent[block] != NONE) {
+        const int p = world.parent[block];
+        const int g = world.parent[p];
+
+        // Same side: rotate the parent first, otherwise block twice
+        if (g != NONE)
+            rotate((world.left[g] == p) == (world.left[p] == block) ? p : block, world);
+
+        rotate(block, world);
+    }
+}
+
+// Returns the stack containing block (the bottom of its stack)
+int find_stack(const int block, World & world) {
+    splay(block, world);
+
+    int bottom = block;
+    while (world.left[bottom] != NONE)
+        bottom = world.left[bottom];
+
+    // Splaying the bottom pays for the walk
+    splay(bottom, world);
+
+    return bottom;
+}
+
+// Separate block (and the blocks above it) from the stack
+// Block is left as the root of the tree of the blocks cut
+void cut_below(const int block, const int stack, World & world) {
+    const int b = world.below[block];
+
+    if (b != NONE)
+        world.above[b] = NONE;
+
+    world.below[block] = NONE;
+    world.top[stack] = b;
+
+    // Blocks below are the left subtree of block
+    splay(block, world);
+
+    const int l = world.left[block];
+    if (l != NONE) {
+        world.parent[l] = NONE;
+        world.left[block] = NONE;
+    }
+}
+
+// Put block (and the blocks above it, up to last)
+// on top of stack
+// (block has to be the root of its tree, see cut_below)
+void put_on_top(const int block, const int last, const int stack, World & world) {
+    const int b = world.top[stack];
+
+    world.below[block] = b;
+    world.above[b] = block;
+    world.top[stack] = last;
+
+    // Old top is the last block of its tree:
+    // once splayed it has no right subtree
+    splay(b, world);
+    world.right[b] = block;
+    world.parent[block] = b;
+}
 
 // Returns blocks on top of element to original pos
 void return_above(
-    const int element, 
-    const int pos,
-    std::vector<std::vector<int>> & world,
-    std::vector<int> & pos_world,
-    std::vector<int> & pos_stack
+    const int element,
+    const int stack,
+    World & world
 ) {
-    // Vector containing element
-    const std::vector<int> & v = world[pos];
-    const int pos_stack_element = pos_stack[element];
+    int block = world.above[element];
+
+    // Nothing to return
+    if (block == NONE)
+        return;
+
+    cut_below(block, stack, world);
+
+    // Return blocks (!= element) on top of it to original pos
+    // (original stacks are empty, see World)
+    while (block != NONE) {
+        const int next = world.above[block];
+
+        world.below[block] = NONE;
+        world.above[block] = NONE;
+        world.top[block] = block;
 
-    // Return blocks (!= element) on top of a to original pos
-    for (int i = pos_stack_element + 1; i < static_cast<int>(v.size()); ++i) {
-        const int block = v[i];
-        world[block].push_back(block);
-        pos_world[block] = block;
-        pos_stack[block] = world[block].size() - 1;
+        world.left[block] = NONE;
+        world.right[block] = NONE;
+        world.parent[block] = NONE;
+
+        block = next;
     }
-    world[pos].resize(pos_stack_element + 1);
 }
 
-int main()
-{
-    // First line of input is number of blocks
-    int n;
-    std::cin >> n;
+// Commands, decoded from the verb and the preposition
+enum Op : std::uint8_t {
+    MOVE_ONTO,
+    MOVE_OVER,
+    PILE_ONTO,
+    PILE_OVER,
+    QUIT
+};
+
+struct Command {
+    Op op;
+    int a;
+    int b;
+};
+
+// Buffer over raw input, refilled as it is consumed
+struct InputBuffer {
+    std::FILE * file;
+    std::size_t pos;
+    std::size_t size;
+    char data[BUFFER_SIZE];
+};
+
+// Returns next input character, or EOF
+int next_char(InputBuffer & input) {
+    if (input.pos == input.size) {
+        input.size = std::fread(input.data, 1, BUFFER_SIZE, input.file);
+        input.pos = 0;
+
+        if (input.size == 0)
+            return EOF;
+    }
+
+    return static_cast<unsigned char>(input.data[input.pos++]);
+}
+
+// Skip whitespace, returns first character after it (or EOF)
+int skip_spaces(InputBuffer & input) {
+    int c;
+    do {
+        c = next_char(input);
+    } while (c == ' ' || c == '\n' || c == '\r' || c == '\t');
+
+    return c;
+}
+
+// Read a non-negative integer
+bool read_int(InputBuffer & input, int & value) {
+    int c = skip_spaces(input);
+    if (c < '0' || c > '9')
+        return false;
+
+    value = 0;
+    while (c >= '0' && c <= '9') {
+        value = 10 * value + (c - '0');
+        c = next_char(input);
+    }
+
+    return true;
+}
+
+// Read a word, keeping only its first two characters
+// (enough to tell apart move/pile/quit and onto/over)
+bool read_word(InputBuffer & input, char & first, char & second) {
+    int c = skip_spaces(input);
+    if (c == EOF)
+        return false;
+
+    first = c;
+    second = 0;
+
+    c = next_char(input);
+    if (c != EOF && c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+        second = c;
+
+        do {
+            c = next_char(input);
+        } while (c != EOF && c != ' ' && c != '\n' && c != '\r' && c != '\t');
+    }
+
+    return true;
+}
+
+// Parse next text command
+// (end of input is handled as quit)
+void parse_command(InputBuffer & input, Command & command) {
+    char verb_first;
+    char verb_second;
+    if (!read_word(input, verb_first, verb_second) || verb_first == 'q') {
+        command.op = QUIT;
+        return;
+    }
+
+    char prep_first;
+    char prep_second;
+    if (!read_int(input, command.a)
+        || !read_word(input, prep_first, prep_second)
+        || !read_int(input, command.b)) {
+        command.op = QUIT;
+        return;
+    }
+
+    // "onto" and "over" differ in their second character
+    const bool is_onto = prep_second == 'n';
+
+    if (verb_first == 'm')
+        command.op = is_onto ? MOVE_ONTO : MOVE_OVER;
+    else
+        command.op = is_onto ? PILE_ONTO : PILE_OVER;
+}
+
+// Command logs are binary files with
+//  - a header: LOG_MAGIC (8 bytes) and number of blocks (4 bytes)
+//  - a record of 8 bytes per command:
+//      op in bits 0-1, a in bits 2-32, b in bits 33-63
+// Quit is not stored, logs end with the file
+// Integers are stored with the byte order of the machine
+struct LogHeader {
+    char magic[8];
+    std::uint32_t n;
+};
+
+std::uint64_t pack_command(const Command & command) {
+    return static_cast<std::uint64_t>(command.op)
+        | static_cast<std::uint64_t>(command.a) << 2
+        | static_cast<std::uint64_t>(command.b) << 33;
+}
+
+// Read next logged command
+// (end of log is handled as quit)
+void read_logged_command(InputBuffer & input, Command & command) {
+    unsigned char bytes[sizeof(std::uint64_t)];
+    for (std::size_t i = 0; i < sizeof(bytes); ++i) {
+        const int c = next_char(input);
+        if (c == EOF) {
+            command.op = QUIT;
+            return;
+        }
+        bytes[i] = c;
+    }
+
+    std::uint64_t record;
+    std::memcpy(&record, bytes, sizeof(record));
+
+    command.op = static_cast<Op>(record & 0x3);
+    command.a = static_cast<int>((record >> 2) & 0x7FFFFFFF);
+    command.b = static_cast<int>((record >> 33) & 0x7FFFFFFF);
+}
+
+// Commands are logged in batches of LOG_BATCH records
+struct LogWriter {
+    std::FILE * file;
+    std::size_t count;
+    std::uint64_t records[LOG_BATCH];
+};
+
+void flush_log(LogWriter & log) {
+    std::fwrite(log.records, sizeof(std::uint64_t), log.count, log.file);
+    log.count = 0;
+}
+
+void log_command(LogWriter & log, const Command & command) {
+    log.records[log.count++] = pack_command(command);
+
+    if (log.count == LOG_BATCH)
+        flush_log(log);
+}
+
+// Apply a command to the world
+void apply_command(const Command & command, World & world) {
+    const int a = command.a;
+    const int b = command.b;
+
+    // Ignore invalid commands
+    // Same blocks
+    if (a == b)
+        return;
+
+    // Blocks are in same stack
+    const int pos_a = find_stack(a, world);
+    const int pos_b = find_stack(b, world);
+    if (pos_a == pos_b)
+        return;
+
+    if (command.op == MOVE_ONTO || command.op == MOVE_OVER) {
+        // Return blocks on top of a to original pos
+        return_above(a, pos_a, world);
 
-    // Vector of vectors to store world
-    std::vector<std::vector<int>> world(n);
+        // For "onto" also the blocks on top of b
+        if (command.op == MOVE_ONTO)
+            return_above(b, pos_b, world);
 
-    // Vector with blocks positions in world
-    std::vector<int> pos_world(n);
+        // Move a on top of stack containing b
+        // (for "onto" b is now the top)
+        cut_below(a, pos_a, world);
+        put_on_top(a, a, pos_b, world);
+    } else {
+        // Only option here is "pile"
+        // For "onto" return blocks on top of b to original pos
+        if (command.op == PILE_ONTO)
+            return_above(b, pos_b, world);
 
-    // Vector with blocks positions in stack
-    std::vector<int> pos_stack(n, 0);
+        // Move (a and blocks above) on top of stack containing b
+        const int last = world.top[pos_a];
+        cut_below(a, pos_a, world);
+        put_on_top(a, last, pos_b, world);
+    }
+}
+
+// Output buffer, sized once for the largest world dump
+struct OutputBuffer {
+    std::vector<char> data;
+    std::size_t size;
+};
+
+// Largest dump of a world with n blocks:
+// a line per stack ("i:\n") and " j" per block,
+// plus a line with the number of commands for snapshots
+std::size_t max_dump_size(const int n) {
+    std::size_t digits = 1;
+    for (int i = n; i >= 10; i /= 10)
+        ++digits;
+
+    return static_cast<std::size_t>(n) * (2 * digits + 4) + 64;
+}
+
+// Pairs of digits "00" to "99"
+const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Write decimal digits of value at out, returns end of the digits
+// (two digits are produced per division)
+char * write_uint(char * out, std::uint64_t value) {
+    char digits[20];
+    char * end = digits + sizeof(digits);
+    char * begin = end;
+
+    while (value >= 100) {
+        const std::size_t pair = 2 * (value % 100);
+        value /= 100;
+        *--begin = digit_pairs[pair + 1];
+        *--begin = digit_pairs[pair];
+    }
+
+    if (value >= 10) {
+        *--begin = digit_pairs[2 * value + 1];
+        *--begin = digit_pairs[2 * value];
+    }
+    else {
+        *--begin = static_cast<char>('0' + value);
+    }
+
+    std::memcpy(out, begin, end - begin);
+    return out + (end - begin);
+}
+
+// Format world in output format
+void dump_world(const World & world, const int n, OutputBuffer & output) {
+    char * out = output.data.data() + output.size;
 
-    // Initialize world and positions
     for (int i = 0; i < n; ++i) {
-        world[i].push_back(i);
-        pos_world[i] = i;
+        out = write_uint(out, i);
+        *out++ = ':';
+
+        // If stack is empty no space is written
+        // (otherwise i is its bottom block)
+        if (world.top[i] != NONE) {
+            for (int block = i; block != NONE; block = world.above[block]) {
+                *out++ = ' ';
+                out = write_uint(out, block);
+            }
+        }
+
+        *out++ = '\n';
+    }
+
+    output.size = out - output.data.data();
+}
+
+// Write all bytes to a file descriptor, in a few large calls
+bool write_all(const int fd, const char * data, std::size_t size) {
+#ifdef HAVE_WRITE
+    while (size > 0) {
+        const std::size_t chunk = size < WRITE_CHUNK ? size : WRITE_CHUNK;
+        const ssize_t n = write(fd, data, chunk);
+        if (n <= 0)
+            return false;
+
+        data += n;
+        size -= n;
     }
 
-    // Parse commands
+    return true;
+#else
+    std::FILE * file = fd == 1 ? stdout : nullptr;
+    return file && std::fwrite(data, 1, size, file) == size;
+#endif
+}
+
+// Snapshots are formatted by the main thread and written by this one,
+// so commands keep being processed while a snapshot is written
+// Buffers are swapped, not copied:
+//  - main thread formats into `front`
+//  - `front` is exchanged with `pending` (waiting if it is still full)
+//  - writer exchanges `pending` with `back` and writes `back`
+struct SnapshotWriter {
+    int fd;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    OutputBuffer front;
+    OutputBuffer pending;
+    OutputBuffer back;
+
+    bool has_pending;
+    bool is_finished;
+};
+
+void run_snapshot_writer(SnapshotWriter & writer) {
     for (;;) {
-        std::string verb;
-        std::cin >> verb;
+        {
+            std::unique_lock<std::mutex> lock(writer.mutex);
+            writer.changed.wait(lock, [&]() {
+                return writer.has_pending || writer.is_finished;
+            });
+
+            if (!writer.has_pending)
+                return;
+
+            std::swap(writer.pending, writer.back);
+            writer.has_pending = false;
+        }
+        writer.changed.notify_all();
+
+        if (!write_all(writer.fd, writer.back.data.data(), writer.back.size))
+            std::cerr << "Could not write snapshot\n";
+    }
+}
+
+// Format a snapshot of the world after `count` commands
+// and hand it to the writer thread
+void take_snapshot(
+    SnapshotWriter & writer,
+    const World & world,
+    const int n,
+    const std::uint64_t count
+) {
+    OutputBuffer & front = writer.front;
+    front.size = 0;
+
+    char * out = front.data.data();
+    std::memcpy(out, "# commands: ", 12);
+    out = write_uint(out + 12, count);
+    *out++ = '\n';
+    front.size = out - front.data.data();
+
+    dump_world(world, n, front);
+
+    {
+        std::unique_lock<std::mutex> lock(writer.mutex);
+        writer.changed.wait(lock, [&]() { return !writer.has_pending; });
+
+        std::swap(writer.front, writer.pending);
+        writer.has_pending = true;
+    }
+    writer.changed.notify_all();
+}
+
+int main(int argc, char * argv[])
+{
+    // Options:
+    //  --replay PATH  read commands from a command log instead of text input
+    //  --record PATH  write the commands read to a command log
+    //  --snapshot PATH --snapshot-every K
+    //                 write the world to PATH every K commands,
+    //                 each snapshot preceded by "# commands: count"
+    std::string replay_path;
+    std::string record_path;
+    std::string snapshot_path;
+    std::uint64_t snapshot_every = 0;
 
-        if (!verb.compare("quit"))
+    for (int i = 1; i < argc; ++i) {
+        const std::string option = argv[i];
+
+        if (option == "--replay" && i + 1 < argc) {
+            replay_path = argv[++i];
+        }
+        else if (option == "--record" && i + 1 < argc) {
+            record_path = argv[++i];
+        }
+        else if (option == "--snapshot" && i + 1 < argc) {
+            snapshot_path = argv[++i];
+        }
+        else if (option == "--snapshot-every" && i + 1 < argc) {
+            snapshot_every = std::stoull(argv[++i]);
+        }
+        else {
+            std::cerr << "Unknown option: " << option << "\n";
+            return 1;
+        }
+    }
+
+    // Input buffer (large, kept out of the stack)
+    static InputBuffer input;
+    input.pos = 0;
+    input.size = 0;
+
+    // Number of blocks
+    int n = 0;
+
+    if (replay_path.empty()) {
+        // First line of input is number of blocks
+        input.file = stdin;
+        read_int(input, n);
+    }
+    else {
+        input.file = std::fopen(replay_path.c_str(), "rb");
+
+        LogHeader header;
+        if (!input.file
+            || std::fread(&header, sizeof(header), 1, input.file) != 1
+            || std::strncmp(header.magic, LOG_MAGIC, sizeof(header.magic)) != 0) {
+            std::cerr << "Invalid command log: " << replay_path << "\n";
+            return 1;
+        }
+
+        n = header.n;
+    }
+
+    // Command log being recorded
+    static LogWriter log;
+    log.file = nullptr;
+    log.count = 0;
+
+    if (!record_path.empty()) {
+        log.file = std::fopen(record_path.c_str(), "wb");
+        if (!log.file) {
+            std::cerr << "Could not write command log: " << record_path << "\n";
+            return 1;
+        }
+
+        LogHeader header = {};
+        std::strncpy(header.magic, LOG_MAGIC, sizeof(header.magic));
+        header.n = n;
+        std::fwrite(&header, sizeof(header), 1, log.file);
+    }
+
+    // Linked stacks to store world
+    World world;
+    world.below.assign(n, NONE);
+    world.above.assign(n, NONE);
+    world.left.assign(n, NONE);
+    world.right.assign(n, NONE);
+    world.parent.assign(n, NONE);
+
+    // Initialize world: each block is alone in its stack
+    world.top.resize(n);
+    for (int i = 0; i < n; ++i)
+        world.top[i] = i;
+
+    // Writer of periodic snapshots
+    static SnapshotWriter snapshots;
+    snapshots.fd = -1;
+    snapshots.has_pending = false;
+    snapshots.is_finished = false;
+
+    if (!snapshot_path.empty() && snapshot_every > 0) {
+#ifdef HAVE_WRITE
+        snapshots.fd = open(snapshot_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+        if (snapshots.fd < 0) {
+            std::cerr << "Could not write snapshots: " << snapshot_path << "\n";
+            return 1;
+        }
+
+        const std::size_t size = max_dump_size(n);
+        snapshots.front.data.resize(size);
+        snapshots.pending.data.resize(size);
+        snapshots.back.data.resize(size);
+
+        snapshots.thread = std::thread(run_snapshot_writer, std::ref(snapshots));
+    }
+
+    // Number of commands read
+    std::uint64_t count = 0;
+
+    // Parse and apply commands
+    for (;;) {
+        Command command;
+
+        if (replay_path.empty())
+            parse_command(input, command);
+        else
+            read_logged_command(input, command);
+
+        if (command.op == QUIT)
             break;
 
-        int a;
-        std::cin >> a;
-
-        std::string prep;
-        std::cin >> prep;
-
-        int b;
-        std::cin >> b;
-
-        // Ignore invalid commands
-        // Same blocks
-        if (a == b)
-            continue;
-
-        // Blocks are in same stack
-        const int pos_a = pos_world[a];
-        const int pos_b = pos_world[b];
-        if (pos_a == pos_b)
-            continue;
-
-        if (!verb.compare("move")) {
-            if (!prep.compare("onto")) {
-                // Return blocks on top of a and b to original pos
-                return_above(a, pos_a, world, pos_world, pos_stack);
-                return_above(b, pos_b, world, pos_world, pos_stack);
-
-                // Move a on top of b
-                world[pos_b].push_back(a);
-                world[pos_a].pop_back();
-                pos_world[a] = pos_b;
-                pos_stack[a] = world[pos_b].size() - 1;
-            } else {
-                // Only option here is "over"
-                return_above(a, pos_a, world, pos_world, pos_stack);
-
-                // Move a on top of stack containing b
-                world[pos_b].push_back(a);
-                world[pos_a].pop_back();
-                pos_world[a] = pos_b;
-                pos_stack[a] = world[pos_b].size() - 1;
-            }
-        } else {
-            // Only option here is "pile"
-            if (!prep.compare("onto")) {
-                // Return blocks on top of b to original pos
-                return_above(b, pos_b, world, pos_world, pos_stack);
-                
-                // Move (a and blocks above) on top of b
-                const std::vector<int> & v_a = world[pos_a];
-                const int pos_stack_a = pos_stack[a];
-                // (This should be pos_stack[b])
-                const int final_stack_b = world[pos_b].size() - 1;
-                int j = 0;
-                for (int i = pos_stack[a]; i < static_cast<int>(v_a.size()); ++i) {
-                    const int block = v_a[i];
-                    world[pos_b].push_back(block);
-                    pos_world[block] = pos_b;
-                    pos_stack[block] = final_stack_b + 1 + j;
-                    ++j;
-                }
-                world[pos_a].resize(pos_stack_a);
-            } else {
-                // Only option here is "over"
-                // Move (a and blocks above) on top of stack containing b
-                const std::vector<int> & v_a = world[pos_a];
-                const int pos_stack_a = pos_stack[a];
-                const int final_stack_b = world[pos_b].size() - 1;
-                int j = 0;
-                for (int i = pos_stack[a]; i < static_cast<int>(v_a.size()); ++i) {
-                    const int block = v_a[i];
-                    world[pos_b].push_back(block);
-                    pos_world[block] = pos_b;
-                    pos_stack[block] = final_stack_b + 1 + j;
-                    ++j;
-                }
-                world[pos_a].resize(pos_stack_a);
-            }
+        if (log.file)
+            log_command(log, command);
+
+        apply_command(command, world);
+
+        ++count;
+        if (snapshots.fd >= 0 && count % snapshot_every == 0)
+            take_snapshot(snapshots, world, n, count);
+    }
+
+    if (snapshots.fd >= 0) {
+        {
+            std::lock_guard<std::mutex> lock(snapshots.mutex);
+            snapshots.is_finished = true;
         }
+        snapshots.changed.notify_all();
+        snapshots.thread.join();
+
+#ifdef HAVE_WRITE
+        close(snapshots.fd);
+#endif
     }
 
+    if (log.file) {
+        flush_log(log);
+        std::fclose(log.file);
+    }
+
+    if (!replay_path.empty())
+        std::fclose(input.file);
+
     // Write output
-    for (int i = 0; i < n; ++i) {
-        std::cout << i << ":";
-        const std::vector<int> & blocks = world[i];
+    OutputBuffer output;
+    output.data.resize(max_dump_size(n));
+    output.size = 0;
 
-        // If blocks is empty no space is written
-        for (std::size_t j = 0; j < blocks.size(); ++j)
-                std::cout << " " << blocks[j];
+    dump_world(world, n, output);
+    write_all(1, output.data.data(), output.size);
 
-        std::cout << "\n";
-    }
-    
     return 0;
 }
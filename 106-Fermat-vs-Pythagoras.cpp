@@ -1,27 +1,516 @@
 #include <iostream>
-#include <cmath>
+#include <cstdint>
 #include <vector>
 #include <numeric>
+#include <string>
+#include <algorithm>
+#include <climits>
+#include <thread>
+#include <atomic>
 
 #define MAX_N 1000000
 
-// Compute greatest common divisor
-// using Euclidean algorithm
-int gcd(const int a, const int b) {
-    if (b == 0)
-        return abs(a);
+// Number of subtrees of primitives per thread in the parallel mode
+// (subtrees are very uneven, so many more than threads are used)
+#define TASKS_PER_THREAD 16
 
-    return gcd(b, a % b);
+// Numbers per window in the segmented mode
+// (window data takes about 700 KB, to stay in L2 cache)
+#define SEGMENT_SIZE 8192
+
+// Maximum number of distinct prime factors of a number below 2^32
+#define MAX_FACTORS 10
+
+struct Triple {
+    int x;
+    int y;
+    int z;
+};
+
+// Push children of a primitive triple with z <= n
+void push_children(const Triple & t, const int n, std::vector<Triple> & triples) {
+    // Children are computed with 8 bytes, since 3z can overflow int
+    const std::int64_t x = t.x;
+    const std::int64_t y = t.y;
+    const std::int64_t z = t.z;
+
+    const std::int64_t children[3][3] = {
+        { x - 2 * y + 2 * z,  2 * x - y + 2 * z,  2 * x - 2 * y + 3 * z},
+        { x + 2 * y + 2 * z,  2 * x + y + 2 * z,  2 * x + 2 * y + 3 * z},
+        {-x + 2 * y + 2 * z, -2 * x + y + 2 * z, -2 * x + 2 * y + 3 * z}
+    };
+
+    for (const auto & child : children) {
+        if (child[2] <= n)
+            triples.push_back({
+                static_cast<int>(child[0]),
+                static_cast<int>(child[1]),
+                static_cast<int>(child[2])
+            });
+    }
+}
+
+// Call f(triple) for every primitive Pythagorean triple with z <= n
+// in the subtree of root (root included, its z has to be <= n)
+// Primitives form a ternary tree (Berggren/Barning) rooted at (3, 4, 5)
+// Children always have a larger z, so the walk stops at z > n
+// The tree is walked depth-first with an explicit stack
+// (`stack` is only a buffer, reused between calls)
+template <class F>
+void for_each_primitive_from(
+    const Triple & root,
+    const int n,
+    std::vector<Triple> & stack,
+    F f
+) {
+    stack.clear();
+    stack.push_back(root);
+
+    while (!stack.empty()) {
+        const Triple t = stack.back();
+        stack.pop_back();
+
+        f(t);
+
+        push_children(t, n, stack);
+    }
+}
+
+// Call f(triple) for every primitive Pythagorean triple with z <= n
+template <class F>
+void for_each_primitive(const int n, std::vector<Triple> & stack, F f) {
+    if (n >= 5)
+        for_each_primitive_from({3, 4, 5}, n, stack, f);
+}
+
+// Count bits set in a word
+int popcount(const std::uint64_t word) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(word);
+#else
+    std::uint64_t w = word - ((word >> 1) & 0x5555555555555555ULL);
+    w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+    w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<int>((w * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Set bits of the numbers part of the triples kx, ky, kz (with kz <= n)
+// Bit m - 1 corresponds to number m
+void mark_multiples(const Triple & t, const int n, std::uint64_t * bits) {
+    for (int k = 1; k * t.z <= n; ++k) {
+        const int numbers[3] = {k * t.x - 1, k * t.y - 1, k * t.z - 1};
+
+        for (const int m : numbers)
+            bits[m / 64] |= std::uint64_t(1) << (m % 64);
+    }
+}
+
+// Run f(t) for t = 0 to n_threads - 1, each in its own thread
+// (f(0) runs in the calling thread)
+template <class F>
+void run_threads(const unsigned n_threads, F f) {
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < n_threads; ++t)
+        threads.emplace_back(f, t);
+
+    f(0);
+
+    for (std::thread & thread : threads)
+        thread.join();
+}
+
+// Count primitives (n_prim) and numbers not part of a triple (n_p)
+// for a single n using n_threads threads
+// Subtrees of primitives are shared between threads,
+// each thread marks numbers into its own packed bitset
+// Bitsets are then merged with OR, word ranges split between threads,
+// and covered numbers counted with popcount
+void count_parallel(
+    const int n,
+    const unsigned n_threads,
+    int & n_prim,
+    int & n_p
+) {
+    const std::size_t n_words = (static_cast<std::size_t>(n) + 63) / 64;
+    std::vector<std::vector<std::uint64_t>> bitsets(
+        n_threads, std::vector<std::uint64_t>(n_words, 0));
+
+    // Expand the top of the tree (breadth first) until there are
+    // enough subtrees, expanded triples are marked here
+    std::vector<Triple> roots;
+    std::size_t head = 0;
+    n_prim = 0;
+
+    if (n >= 5)
+        roots.push_back({3, 4, 5});
+
+    while (head < roots.size() && roots.size() - head < TASKS_PER_THREAD * n_threads) {
+        const Triple t = roots[head++];
+
+        ++n_prim;
+        mark_multiples(t, n, bitsets[0].data());
+        push_children(t, n, roots);
+    }
+
+    // Walk the remaining subtrees in parallel
+    std::atomic<std::size_t> next_root(head);
+    std::vector<int> thread_prim(n_threads, 0);
+    std::vector<int> thread_covered(n_threads, 0);
+
+    const auto mark = [&](const unsigned t) {
+        std::vector<Triple> stack;
+        std::uint64_t * bits = bitsets[t].data();
+
+        for (;;) {
+            const std::size_t r = next_root.fetch_add(1);
+            if (r >= roots.size())
+                break;
+
+            for_each_primitive_from(roots[r], n, stack, [&](const Triple & triple) {
+                ++thread_prim[t];
+                mark_multiples(triple, n, bits);
+            });
+        }
+    };
+
+    // Merge bitsets into the first one and count covered numbers
+    const auto reduce = [&](const unsigned t) {
+        const std::size_t begin = n_words * t / n_threads;
+        const std::size_t end = n_words * (t + 1) / n_threads;
+
+        std::uint64_t * merged = bitsets[0].data();
+        for (unsigned other = 1; other < n_threads; ++other) {
+            const std::uint64_t * bits = bitsets[other].data();
+
+            for (std::size_t w = begin; w < end; ++w)
+                merged[w] |= bits[w];
+        }
+
+        int covered = 0;
+        for (std::size_t w = begin; w < end; ++w)
+            covered += popcount(merged[w]);
+
+        thread_covered[t] = covered;
+    };
+
+    run_threads(n_threads, mark);
+    run_threads(n_threads, reduce);
+
+    n_p = n;
+    for (unsigned t = 0; t < n_threads; ++t) {
+        n_prim += thread_prim[t];
+        n_p -= thread_covered[t];
+    }
+}
+
+// Answer all queries with a single generation pass up to max(n)
+// For each number m, min_z[m] stores the smallest z of a triple
+// containing m: m is part of a triple with x, y, z <= n iff min_z[m] <= n
+// Primitives and covered numbers are then counted by z,
+// and cumulative counts answer every query
+void answer_offline(const std::vector<int> & queries) {
+    const int max_n = queries.empty() ? 0 : *std::max_element(queries.begin(), queries.end());
+
+    std::vector<int> min_z(max_n + 1, INT_MAX);
+
+    // Number of primitives with each z
+    std::vector<int> prim_by_z(max_n + 1, 0);
+
+    std::vector<Triple> stack;
+    for_each_primitive(max_n, stack, [&](const Triple & t) {
+        ++prim_by_z[t.z];
+
+        // Multiples kx, ky, kz are part of a triple with z = kz
+        for (int k = 1; k * t.z <= max_n; ++k) {
+            const int kz = k * t.z;
+            min_z[k * t.x] = std::min(min_z[k * t.x], kz);
+            min_z[k * t.y] = std::min(min_z[k * t.y], kz);
+            min_z[kz] = std::min(min_z[kz], kz);
+        }
+    });
+
+    // Number of covered numbers (part of a triple) by min_z
+    std::vector<int> covered_by_z(max_n + 1, 0);
+    for (int m = 1; m <= max_n; ++m) {
+        if (min_z[m] <= max_n)
+            ++covered_by_z[min_z[m]];
+    }
+
+    // Cumulative counts: index n counts all triples with z <= n
+    for (int z = 1; z <= max_n; ++z) {
+        prim_by_z[z] += prim_by_z[z - 1];
+        covered_by_z[z] += covered_by_z[z - 1];
+    }
+
+    // Write output, in input order
+    for (const int n : queries)
+        std::cout << prim_by_z[n] << " " << n - covered_by_z[n] << "\n";
+}
+
+// Segmented mode
+// Memory does not grow with n: numbers are classified window by window
+// using their factorization (from a segmented sieve) instead of marking
+// multiples of triples, since any window can be hit by almost every triple
+//
+// A number m <= n is part of a triple with z <= n iff:
+//  - m is a hypotenuse: m has a prime factor = 1 (mod 4), or
+//  - m is a leg of a triple with z <= n:
+//      m^2 = (z - y)(z + y) = s * t with s < m, both with the same parity
+//      z = (s + t) / 2 decreases as s grows towards m, so the best s
+//      is the largest valid divisor of m^2 below m
+//    For odd m: s + m^2 / s <= 2n, for any divisor s of m^2 below m
+//    For even m (M = m / 2, s = 2s'): s' + M^2 / s' <= n,
+//    for any divisor s' of M^2 below M
+
+struct Factor {
+    std::uint32_t p;
+    std::uint8_t e;
+};
+
+// Factorization of the numbers in a window
+struct Segment {
+    // Product of the prime factors found for each number
+    std::uint32_t found[SEGMENT_SIZE];
+
+    // The number has a prime factor = 1 (mod 4)
+    bool is_hypotenuse[SEGMENT_SIZE];
+
+    // Prime factors = 2, 3 (mod 4), in increasing order
+    std::uint8_t n_factors[SEGMENT_SIZE];
+    Factor factors[SEGMENT_SIZE][MAX_FACTORS];
+};
+
+// Primes up to limit (sieve of Eratosthenes)
+std::vector<std::uint32_t> primes_up_to(const std::uint32_t limit) {
+    std::vector<bool> is_composite(limit + 1, false);
+    std::vector<std::uint32_t> primes;
+
+    for (std::uint32_t i = 2; i <= limit; ++i) {
+        if (is_composite[i])
+            continue;
+
+        primes.push_back(i);
+        for (std::uint64_t j = static_cast<std::uint64_t>(i) * i; j <= limit; j += i)
+            is_composite[j] = true;
+    }
+
+    return primes;
+}
+
+// Factorize numbers lo to hi - 1 (hi - lo <= SEGMENT_SIZE)
+// `primes` has to contain all primes up to sqrt(hi - 1)
+void factorize_segment(
+    const std::uint32_t lo,
+    const std::uint32_t hi,
+    const std::vector<std::uint32_t> & primes,
+    Segment & segment
+) {
+    const std::uint32_t size = hi - lo;
+
+    for (std::uint32_t i = 0; i < size; ++i) {
+        segment.found[i] = 1;
+        segment.is_hypotenuse[i] = false;
+        segment.n_factors[i] = 0;
+    }
+
+    // Multiples of p, p^2, p^3... are visited,
+    // so exponents are found without divisions
+    for (const std::uint32_t p : primes) {
+        if (static_cast<std::uint64_t>(p) * p > hi - 1)
+            break;
+
+        const bool is_hypotenuse = p % 4 == 1;
+
+        for (std::uint64_t power = p; power < hi; power *= p) {
+            // First multiple of the power in the window
+            const std::uint64_t first = (lo + power - 1) / power * power;
+
+            for (std::uint64_t m = first; m < hi; m += power) {
+                const std::uint32_t i = m - lo;
+                segment.found[i] *= p;
+
+                if (is_hypotenuse)
+                    segment.is_hypotenuse[i] = true;
+                else if (power == p)
+                    segment.factors[i][segment.n_factors[i]++] = {p, 1};
+                else
+                    ++segment.factors[i][segment.n_factors[i] - 1].e;
+            }
+        }
+    }
+
+    // What remains is 1 or a prime larger than sqrt(hi - 1)
+    for (std::uint32_t i = 0; i < size; ++i) {
+        const std::uint32_t p = (lo + i) / segment.found[i];
+        if (p <= 1)
+            continue;
+
+        if (p % 4 == 1)
+            segment.is_hypotenuse[i] = true;
+        else
+            segment.factors[i][segment.n_factors[i]++] = {p, 1};
+    }
+}
+
+// Look for the largest divisor of M^2 below M (stored in best)
+// trying exponents 0 to 2e for factors i onwards of M
+void search_divisor(
+    const Factor * factors,
+    const int n_factors,
+    const int i,
+    const std::uint64_t divisor,
+    const std::uint64_t M,
+    std::uint64_t & best
+) {
+    if (i == n_factors) {
+        if (divisor > best)
+            best = divisor;
+        return;
+    }
+
+    // Larger exponents only increase the divisor
+    std::uint64_t current = divisor;
+    for (int e = 0; e <= 2 * factors[i].e && current < M; ++e) {
+        search_divisor(factors, n_factors, i + 1, current, M, best);
+        current *= factors[i].p;
+    }
+}
+
+// Check if m (without prime factors = 1 (mod 4)) is a leg
+// of a triple with z <= n
+bool is_leg(
+    const std::uint64_t m,
+    const Factor * m_factors,
+    const int m_n_factors,
+    const std::uint64_t n
+) {
+    // Factors of M, see above
+    Factor factors[MAX_FACTORS];
+    int n_factors = 0;
+
+    const bool is_even = m % 2 == 0;
+    const std::uint64_t M = is_even ? m / 2 : m;
+    const std::uint64_t bound = is_even ? n : 2 * n;
+
+    for (int f = 0; f < m_n_factors; ++f) {
+        Factor factor = m_factors[f];
+        if (factor.p == 2 && is_even)
+            --factor.e;
+
+        if (factor.e > 0)
+            factors[n_factors++] = factor;
+    }
+
+    // 1 and 2 are not part of any triple
+    if (M == 1)
+        return false;
+
+    const std::uint64_t square = M * M;
+
+    // Largest divisor of M is tried first
+    const std::uint64_t s = M / factors[0].p;
+    if (s + square / s <= bound)
+        return true;
+
+    // Otherwise the largest divisor of M^2 below M
+    std::uint64_t best = 1;
+    search_divisor(factors, n_factors, 0, 1, M, best);
+
+    return best + square / best <= bound;
 }
 
-int main()
+// Count primitives (n_prim) and numbers not part of a triple (n_p)
+// for a single n with memory independent of n
+void count_segmented(const int n, int & n_prim, int & n_p) {
+    n_prim = 0;
+    std::vector<Triple> stack;
+    for_each_primitive(n, stack, [&](const Triple &) { ++n_prim; });
+
+    std::uint32_t limit = 1;
+    while (static_cast<std::uint64_t>(limit + 1) * (limit + 1) <= static_cast<std::uint64_t>(n))
+        ++limit;
+
+    const std::vector<std::uint32_t> primes = primes_up_to(limit);
+
+    // Window data is large, kept out of the stack
+    static Segment segment;
+
+    n_p = 0;
+    for (std::uint32_t lo = 1; lo <= static_cast<std::uint32_t>(n); lo += SEGMENT_SIZE) {
+        const std::uint32_t hi = std::min<std::uint64_t>(
+            static_cast<std::uint64_t>(lo) + SEGMENT_SIZE,
+            static_cast<std::uint64_t>(n) + 1);
+
+        factorize_segment(lo, hi, primes, segment);
+
+        for (std::uint32_t i = 0; i < hi - lo; ++i) {
+            if (segment.is_hypotenuse[i])
+                continue;
+
+            if (!is_leg(lo + i, segment.factors[i], segment.n_factors[i], n))
+                ++n_p;
+        }
+    }
+}
+
+int main(int argc, char * argv[])
 {
+    // Options:
+    //  --offline    read all queries first and answer them
+    //               with a single generation pass
+    //  --threads T  answer each query using T threads (0 uses all cores)
+    //  --segmented  answer each query with memory independent of n
+    //               (n can reach 10^9)
+    bool is_offline = false;
+    bool is_segmented = false;
+    unsigned n_threads = 1;
+
+    for (int a = 1; a < argc; ++a) {
+        const std::string option = argv[a];
+
+        if (option == "--offline") {
+            is_offline = true;
+        }
+        else if (option == "--segmented") {
+            is_segmented = true;
+        }
+        else if (option == "--threads" && a + 1 < argc) {
+            n_threads = std::stoul(argv[++a]);
+            if (n_threads == 0)
+                n_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        else {
+            std::cerr << "Unknown option: " << option << "\n";
+            return 1;
+        }
+    }
+
+    if (is_offline) {
+        std::vector<int> queries;
+        for (;;) {
+            int n;
+            std::cin >> n;
+
+            if (!std::cin)
+                break;
+
+            queries.push_back(n);
+        }
+
+        answer_offline(queries);
+        return 0;
+    }
+
     // Vector to keep track of numbers
     // part of any triple (primitive or not),
     // with x, y, z <= n
     std::vector<bool> is_p;
     is_p.reserve(MAX_N);
 
+    // Buffer for the primitives generator
+    std::vector<Triple> stack;
+
     for (;;) {
         // Read input
         int n;
@@ -30,6 +519,19 @@ int main()
         if (!std::cin)
             break;
 
+        if (is_segmented || n_threads > 1) {
+            int n_prim;
+            int n_p;
+
+            if (is_segmented)
+                count_segmented(n, n_prim, n_p);
+            else
+                count_parallel(n, n_threads, n_prim, n_p);
+
+            std::cout << n_prim << " " << n_p << "\n";
+            continue;
+        }
+
         // Reset and initialize is_p
         // Numbers are p unless valid triple
         // is formed with them
@@ -40,38 +542,18 @@ int main()
         // (primitives) with x, y, z <= n
         int n_prim = 0;
 
-        // Generate relatively prime triples
-        // For z to be <= n, i and j < sqrt(n) at least
-        const int limit = static_cast<int>(std::sqrt(n));
-        for (int i = 1; i <= limit; ++i) {
-            for (int j = i + 1; j <= limit; j = j + 1) {
-
-                // Check generated numbers are <= n
-                const int z = j * j + i * i;
-                if (z > n)
-                    break;
-
-                const int y = 2 * i * j;
-                const int x = j * j - i * i;
-
-                // x, y, z are part of a Pyth triple
-                // Also multiples kx, ky, kz will be Pyth triples
-                for (int k = 1; k * z <= n; ++k) {
-                    is_p[k * x - 1] = 0;
-                    is_p[k * y - 1] = 0;
-                    is_p[k * z - 1] = 0;
-                }
-
-                // x, y, z are relatively prime
-                // if only one of i or j is even
-                if ((i + j) % 2 != 0) {
-                    // and if i, j are relatively prime
-                    if (gcd(i, j) == 1) {
-                        ++n_prim;
-                    }
-                }
+        // Generate primitive triples
+        for_each_primitive(n, stack, [&](const Triple & t) {
+            ++n_prim;
+
+            // x, y, z are part of a Pyth triple
+            // Also multiples kx, ky, kz will be Pyth triples
+            for (int k = 1; k * t.z <= n; ++k) {
+                is_p[k * t.x - 1] = 0;
+                is_p[k * t.y - 1] = 0;
+                is_p[k * t.z - 1] = 0;
             }
-        }
+        });
 
         // Sum numbers not part of a triple
         const int n_p = std::accumulate(is_p.begin(), is_p.end(), 0);
@@ -1,19 +1,659 @@
 #include <iostream>
 #include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <cstdint>
 
-int main()
+// The AVX2 kernels are only built with GCC-compatible compilers on x86,
+// they are selected at runtime if the CPU supports it
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_AVX2_KERNEL 1
+#include <immintrin.h>
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+
+// Rows of prefix sums are padded with zero columns to a multiple of it
+// (the number of int16 values in a vector register,
+// thus also a multiple of the int32 ones)
+#define ROW_PADDING 16
+
+// Number of columns in a leaf of the --dynamic trees
+#define BLOCK_SIZE 8
+
+// Largest memory of the --dynamic trees, in bytes
+// (2 GB, enough for grids up to about 1000 x 1000)
+#define MAX_BAND_BYTES (2ULL << 30)
+
+// Number of columns of the prefix sums rows for a grid of `size` columns
+inline int padded_width(const int size) {
+    return (size + ROW_PADDING - 1) / ROW_PADDING * ROW_PADDING;
+}
+
+// Kernels computing the maximum subarray sum of a strip of columns
+// Strip values are lower[c] - upper[c], for c = 0 to width - 1
+// (width is a multiple of ROW_PADDING, padding columns have to be 0)
+// The empty subarray is allowed, so the result is at least 0
+// Acc has to hold twice the largest sum of a subrectangle
+template <typename Acc>
+using StripKernel = Acc (*)(const Acc * upper, const Acc * lower, int width);
+
+// Kadane algorithm over the strip
+template <typename Acc>
+Acc strip_max_scalar(const Acc * upper, const Acc * lower, const int width) {
+    Acc sum = 0;
+    Acc sub_sum = 0;
+
+    for (int j = 0; j < width; ++j) {
+        sum += lower[j] - upper[j];
+
+        if (sum < 0)
+            sum = 0;
+
+        else if (sum > sub_sum)
+            sub_sum = sum;
+    }
+
+    return sub_sum;
+}
+
+#ifdef HAVE_AVX2_KERNEL
+// Vector operations for each accumulator type
+// (int64 has no vector min and max in AVX2, it only has the scalar kernel)
+template <typename Acc>
+struct SimdTraits {
+    static constexpr bool has_avx2 = false;
+};
+
+template <>
+struct SimdTraits<int16_t> {
+    static constexpr bool has_avx2 = true;
+    static constexpr int lanes = 16;
+
+    AVX2_FUNCTION static __m256i add(const __m256i a, const __m256i b) { return _mm256_add_epi16(a, b); }
+    AVX2_FUNCTION static __m256i sub(const __m256i a, const __m256i b) { return _mm256_sub_epi16(a, b); }
+    AVX2_FUNCTION static __m256i min(const __m256i a, const __m256i b) { return _mm256_min_epi16(a, b); }
+    AVX2_FUNCTION static __m256i max(const __m256i a, const __m256i b) { return _mm256_max_epi16(a, b); }
+    AVX2_FUNCTION static __m256i set1(const int16_t x) { return _mm256_set1_epi16(x); }
+
+    // Last value copied to all lanes
+    AVX2_FUNCTION static __m256i broadcast_last(const __m256i x) {
+        // Last pair of values to all pairs, then its second value to both
+        const __m256i pair = _mm256_permutevar8x32_epi32(x, _mm256_set1_epi32(7));
+        return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(pair, 0xFF), 0xFF);
+    }
+
+    // Maximum of the lanes
+    AVX2_FUNCTION static int16_t reduce_max(__m256i x) {
+        x = max(x, _mm256_permute2x128_si256(x, x, 0x01));
+        x = max(x, _mm256_shuffle_epi32(x, 0x4E));
+        x = max(x, _mm256_shuffle_epi32(x, 0xB1));
+        x = max(x, _mm256_srli_epi32(x, 16));
+
+        return static_cast<int16_t>(_mm256_cvtsi256_si32(x));
+    }
+};
+
+template <>
+struct SimdTraits<int32_t> {
+    static constexpr bool has_avx2 = true;
+    static constexpr int lanes = 8;
+
+    AVX2_FUNCTION static __m256i add(const __m256i a, const __m256i b) { return _mm256_add_epi32(a, b); }
+    AVX2_FUNCTION static __m256i sub(const __m256i a, const __m256i b) { return _mm256_sub_epi32(a, b); }
+    AVX2_FUNCTION static __m256i min(const __m256i a, const __m256i b) { return _mm256_min_epi32(a, b); }
+    AVX2_FUNCTION static __m256i max(const __m256i a, const __m256i b) { return _mm256_max_epi32(a, b); }
+    AVX2_FUNCTION static __m256i set1(const int32_t x) { return _mm256_set1_epi32(x); }
+
+    // Last value copied to all lanes
+    AVX2_FUNCTION static __m256i broadcast_last(const __m256i x) {
+        return _mm256_permutevar8x32_epi32(x, _mm256_set1_epi32(7));
+    }
+
+    // Maximum of the lanes
+    AVX2_FUNCTION static int32_t reduce_max(__m256i x) {
+        x = max(x, _mm256_permute2x128_si256(x, x, 0x01));
+        x = max(x, _mm256_shuffle_epi32(x, 0x4E));
+        x = max(x, _mm256_shuffle_epi32(x, 0xB1));
+
+        return _mm256_cvtsi256_si32(x);
+    }
+};
+
+// Shift the values of x up by BYTES bytes (2, 4, 8 or 16),
+// filling the lowest positions with the values of fill
+// (fill has to hold the same value in all positions)
+template <int BYTES>
+AVX2_FUNCTION inline __m256i shift_up(const __m256i x, const __m256i fill) {
+    // Lower half of fill below lower half of x
+    const __m256i carried = _mm256_permute2x128_si256(x, fill, 0x02);
+
+    return _mm256_alignr_epi8(x, carried, 16 - BYTES);
+}
+
+// By 16 bytes the lower half of fill is the lower half of the result
+template <>
+AVX2_FUNCTION inline __m256i shift_up<16>(const __m256i x, const __m256i fill) {
+    return _mm256_permute2x128_si256(x, fill, 0x02);
+}
+
+// First step of the scans, only needed by 16-bit lanes
+// (the other steps shift by whole 32-bit lanes)
+AVX2_FUNCTION inline __m256i scan_add_first(const __m256i x, SimdTraits<int16_t>) {
+    return _mm256_add_epi16(x, shift_up<2>(x, _mm256_setzero_si256()));
+}
+
+AVX2_FUNCTION inline __m256i scan_add_first(const __m256i x, SimdTraits<int32_t>) {
+    return x;
+}
+
+AVX2_FUNCTION inline __m256i scan_min_first(const __m256i x, SimdTraits<int16_t>) {
+    const __m256i infinity = _mm256_set1_epi16(std::numeric_limits<int16_t>::max());
+    return _mm256_min_epi16(x, shift_up<2>(x, infinity));
+}
+
+AVX2_FUNCTION inline __m256i scan_min_first(const __m256i x, SimdTraits<int32_t>) {
+    return x;
+}
+
+// Inclusive prefix sums of the lanes, in log-steps
+template <typename Acc>
+AVX2_FUNCTION inline __m256i scan_add(__m256i x) {
+    using T = SimdTraits<Acc>;
+    const __m256i zero = _mm256_setzero_si256();
+
+    x = scan_add_first(x, T());
+    x = T::add(x, shift_up<4>(x, zero));
+    x = T::add(x, shift_up<8>(x, zero));
+    x = T::add(x, shift_up<16>(x, zero));
+
+    return x;
+}
+
+// Inclusive prefix minimums of the lanes, in log-steps
+template <typename Acc>
+AVX2_FUNCTION inline __m256i scan_min(__m256i x) {
+    using T = SimdTraits<Acc>;
+    const __m256i infinity = T::set1(std::numeric_limits<Acc>::max());
+
+    x = scan_min_first(x, T());
+    x = T::min(x, shift_up<4>(x, infinity));
+    x = T::min(x, shift_up<8>(x, infinity));
+    x = T::min(x, shift_up<16>(x, infinity));
+
+    return x;
+}
+
+// Max subarray sum as the largest difference between
+// a prefix sum and the smallest prefix sum before it:
+//  - prefix sums of a vector of columns are computed with a log-step scan
+//  - minimum prefix sums with the same scan using min
+// Sums and minimums of previous columns are carried in all lanes
+template <typename Acc>
+AVX2_FUNCTION Acc strip_max_avx2(const Acc * upper, const Acc * lower, const int width) {
+    using T = SimdTraits<Acc>;
+    const __m256i zero = _mm256_setzero_si256();
+
+    // Prefix sum and minimum prefix sum of previous columns
+    // (the empty prefix has sum 0)
+    __m256i carry_sum = zero;
+    __m256i carry_min = zero;
+    __m256i best = zero;
+
+    for (int j = 0; j < width; j += T::lanes) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(upper + j));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lower + j));
+
+        // Strip values and their prefix sums
+        const __m256i sum = T::add(scan_add<Acc>(T::sub(b, a)), carry_sum);
+
+        // Minimum prefix sums up to each column
+        const __m256i min = T::min(scan_min<Acc>(sum), carry_min);
+
+        // Minimum prefix sums before each column
+        const __m256i min_before = shift_up<sizeof(Acc)>(min, carry_min);
+        best = T::max(best, T::sub(sum, min_before));
+
+        carry_sum = T::broadcast_last(sum);
+        carry_min = T::broadcast_last(min);
+    }
+
+    return T::reduce_max(best);
+}
+
+// Vector kernel if the CPU supports it (null otherwise),
+// chosen by SimdTraits<Acc>::has_avx2
+template <typename Acc>
+StripKernel<Acc> avx2_kernel(std::true_type) {
+    if (__builtin_cpu_supports("avx2"))
+        return strip_max_avx2<Acc>;
+
+    return nullptr;
+}
+
+template <typename Acc>
+StripKernel<Acc> avx2_kernel(std::false_type) {
+    return nullptr;
+}
+#endif
+
+// Choose the kernel supported by the CPU
+template <typename Acc>
+StripKernel<Acc> select_kernel() {
+#ifdef HAVE_AVX2_KERNEL
+    const StripKernel<Acc> kernel =
+        avx2_kernel<Acc>(std::integral_constant<bool, SimdTraits<Acc>::has_avx2>());
+
+    if (kernel != nullptr)
+        return kernel;
+#endif
+
+    return strip_max_scalar<Acc>;
+}
+
+// Run f(t) for t = 0 to n_threads - 1, each in its own thread
+// (f(0) runs in the calling thread)
+template <typename F>
+void run_threads(const unsigned n_threads, F f) {
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < n_threads; ++t)
+        threads.emplace_back(f, t);
+
+    f(0);
+
+    for (std::thread & thread : threads)
+        thread.join();
+}
+
+// Column prefix sums of the size x size grid, stored by rows:
+// prefix[r * width + j] is the sum of rows 0 to r - 1 in column j
+// Thus the sums of rows top to bottom, for all columns, are
+// prefix[(bottom + 1) * width + j] - prefix[top * width + j],
+// a contiguous strip
+// Rows are padded with zero columns up to width
+template <typename Cell, typename Acc>
+std::vector<Acc> build_prefix(
+    const std::vector<Cell> & grid,
+    const int size,
+    const int width
+) {
+    std::vector<Acc> prefix(static_cast<size_t>(size + 1) * width, 0);
+
+    for (int i = 0; i < size; ++i) {
+        const Acc * previous = &prefix[static_cast<size_t>(i) * width];
+        Acc * current = &prefix[static_cast<size_t>(i + 1) * width];
+
+        for (int j = 0; j < size; ++j)
+            current[j] = previous[j] + grid[static_cast<size_t>(i) * size + j];
+    }
+
+    return prefix;
+}
+
+// Compute max subrectangle sum of the size x size grid
+// Each pair of rows (top, bottom) gives a strip of columns,
+// whose max subarray is the best subrectangle between those rows
+// Top rows are handed out to n_threads threads with an atomic counter,
+// in increasing order: top row t has size - t strips,
+// so the heaviest rows go first and the last ones fill the gaps
+// Each thread keeps its own max, merged at the end
+template <typename Cell, typename Acc>
+Acc max_subrectangle(
+    const std::vector<Cell> & grid,
+    const int size,
+    const unsigned n_threads
+) {
+    const int width = padded_width(size);
+    const std::vector<Acc> prefix = build_prefix<Cell, Acc>(grid, size, width);
+    const StripKernel<Acc> strip_max = select_kernel<Acc>();
+
+    std::atomic<int> next_top(0);
+    std::vector<Acc> thread_max(n_threads, 0);
+
+    run_threads(n_threads, [&](const unsigned t) {
+        Acc max_sum = 0;
+
+        for (;;) {
+            const int top = next_top.fetch_add(1, std::memory_order_relaxed);
+            if (top >= size)
+                break;
+
+            const Acc * upper = &prefix[static_cast<size_t>(top) * width];
+
+            for (int bottom = top; bottom < size; ++bottom) {
+                const Acc * lower = &prefix[static_cast<size_t>(bottom + 1) * width];
+
+                const Acc sub_sum = strip_max(upper, lower, width);
+                if (sub_sum > max_sum)
+                    max_sum = sub_sum;
+            }
+        }
+
+        thread_max[t] = max_sum;
+    });
+
+    return *std::max_element(thread_max.begin(), thread_max.end());
+}
+
+// Whether T can hold values up to max_abs in absolute value
+template <typename T>
+bool holds(const int64_t max_abs) {
+    return max_abs <= std::numeric_limits<T>::max();
+}
+
+// Whether T is a safe accumulator for a size x size grid
+// with values up to max_abs in absolute value:
+// subrectangle sums are at most size^2 * max_abs,
+// and the vector kernel subtracts two of them
+template <typename T>
+bool is_safe_accumulator(const int64_t size, const int64_t max_abs) {
+    return max_abs <= std::numeric_limits<T>::max() / (2 * size * size);
+}
+
+// Max subrectangle sum using the narrowest safe accumulator,
+// trying them from the type of the last argument up
+// (int16, then int32, then int64)
+template <typename Cell>
+int64_t max_subrectangle_from(
+    const std::vector<Cell> & grid,
+    const int size,
+    const int64_t,
+    const unsigned n_threads,
+    int64_t
+) {
+    return max_subrectangle<Cell, int64_t>(grid, size, n_threads);
+}
+
+template <typename Cell>
+int64_t max_subrectangle_from(
+    const std::vector<Cell> & grid,
+    const int size,
+    const int64_t max_abs,
+    const unsigned n_threads,
+    int32_t
+) {
+    if (is_safe_accumulator<int32_t>(size, max_abs))
+        return max_subrectangle<Cell, int32_t>(grid, size, n_threads);
+
+    return max_subrectangle_from(grid, size, max_abs, n_threads, int64_t());
+}
+
+template <typename Cell>
+int64_t max_subrectangle_from(
+    const std::vector<Cell> & grid,
+    const int size,
+    const int64_t max_abs,
+    const unsigned n_threads,
+    int16_t
+) {
+    if (is_safe_accumulator<int16_t>(size, max_abs))
+        return max_subrectangle<Cell, int16_t>(grid, size, n_threads);
+
+    return max_subrectangle_from(grid, size, max_abs, n_threads, int32_t());
+}
+
+// Max subrectangle sum with Cell values, using the narrowest safe accumulator
+// (at least as wide as Cell, since the bound covers every cell)
+// Narrower accumulators put more columns in each vector
+template <typename Cell>
+int64_t max_subrectangle_of(
+    const std::vector<int64_t> & values,
+    const int size,
+    const int64_t max_abs,
+    const unsigned n_threads
+) {
+    const std::vector<Cell> grid(values.begin(), values.end());
+
+    return max_subrectangle_from(grid, size, max_abs, n_threads, Cell());
+}
+
+// Max subrectangle sum, choosing the narrowest cell type for the values
+int64_t max_subrectangle(
+    const std::vector<int64_t> & values,
+    const int size,
+    const unsigned n_threads
+) {
+    if (size <= 0)
+        return 0;
+
+    int64_t max_abs = 0;
+    for (const int64_t x : values)
+        max_abs = std::max(max_abs, x < 0 ? -x : x);
+
+    if (holds<int16_t>(max_abs))
+        return max_subrectangle_of<int16_t>(values, size, max_abs, n_threads);
+
+    if (holds<int32_t>(max_abs))
+        return max_subrectangle_of<int32_t>(values, size, max_abs, n_threads);
+
+    return max_subrectangle_of<int64_t>(values, size, max_abs, n_threads);
+}
+
+// Max subarray summary of a range of columns
+// prefix, suffix and best allow the empty subarray, so they are at least 0
+struct Node {
+    int sum;
+    int prefix;
+    int suffix;
+    int best;
+};
+
+// Summary of two adjacent ranges
+inline Node combine(const Node & left, const Node & right) {
+    Node node;
+    node.sum = left.sum + right.sum;
+    node.prefix = std::max(left.prefix, left.sum + right.prefix);
+    node.suffix = std::max(right.suffix, right.sum + left.suffix);
+    node.best = std::max(std::max(left.best, right.best), left.suffix + right.prefix);
+
+    return node;
+}
+
+// Summary of the strip lower[j] - upper[j], for j = 0 to BLOCK_SIZE - 1
+Node summarize_block(const int * upper, const int * lower) {
+    Node node = {0, 0, 0, 0};
+    int sum = 0;
+
+    for (int j = 0; j < BLOCK_SIZE; ++j) {
+        node.sum += lower[j] - upper[j];
+        node.prefix = std::max(node.prefix, node.sum);
+
+        sum = std::max(sum + lower[j] - upper[j], 0);
+        node.best = std::max(node.best, sum);
+    }
+
+    node.suffix = sum;
+
+    return node;
+}
+
+// Incremental engine for --dynamic
+// For each band of rows (top, bottom) a segment tree over the columns
+// stores the max subarray summary of the band column sums
+// Leaves summarize blocks of BLOCK_SIZE columns, read from the prefix sums
+// (which are kept up to date), so trees are BLOCK_SIZE times smaller
+// Trees are stored bottom-up in arrays of 2 * n_leaves nodes:
+// node i has children 2i and 2i + 1, leaves start at n_leaves
+// (extra leaves are 0 and do not change any summary)
+// Changing cell (r, c) changes column c of the bands with top <= r <= bottom,
+// so an update costs O(size^2 log size) instead of O(size^3)
+// Memory is O(size^3 / BLOCK_SIZE), larger grids are rejected (see MAX_BAND_BYTES)
+struct BandTrees {
+    int size;
+    int width;
+    int n_leaves;
+    // Column prefix sums (see main)
+    std::vector<int> prefix;
+    // Trees of all bands, by band index (see band_index)
+    std::vector<Node> nodes;
+    // Best subarray of each band, i.e. the root of its tree
+    std::vector<int> best;
+};
+
+// Index of band (top, bottom) with top <= bottom
+// Bands are numbered by top row, then by bottom row
+inline int band_index(const int size, const int top, const int bottom) {
+    return top * size - top * (top - 1) / 2 + (bottom - top);
+}
+
+// Tree of band (top, bottom)
+inline Node * band_tree(BandTrees & bands, const int top, const int bottom) {
+    const size_t band = band_index(bands.size, top, bottom);
+    return &bands.nodes[band * 2 * bands.n_leaves];
+}
+
+// Number of leaves of each tree: blocks of a row, rounded up to a power of 2
+int leaf_count(const int width) {
+    const int n_blocks = width / BLOCK_SIZE;
+
+    int n_leaves = 1;
+    while (n_leaves < n_blocks)
+        n_leaves *= 2;
+
+    return n_leaves;
+}
+
+// Memory needed by the trees of all bands, in bytes
+uint64_t band_trees_bytes(const int size, const int width) {
+    if (size <= 0)
+        return 0;
+
+    const uint64_t n_bands = static_cast<uint64_t>(size) * (size + 1) / 2;
+    return n_bands * 2 * leaf_count(width) * sizeof(Node);
+}
+
+// Build the trees of all bands from the column prefix sums
+void build_bands(
+    const std::vector<int> & prefix,
+    const int size,
+    const int width,
+    BandTrees & bands
+) {
+    bands.size = size;
+    bands.width = width;
+    bands.prefix = prefix;
+
+    const int n_blocks = width / BLOCK_SIZE;
+    bands.n_leaves = leaf_count(width);
+
+    const int n_leaves = bands.n_leaves;
+    const int n_bands = size * (size + 1) / 2;
+    bands.nodes.assign(static_cast<size_t>(n_bands) * 2 * n_leaves, Node{0, 0, 0, 0});
+    bands.best.assign(n_bands, 0);
+
+    for (int top = 0; top < size; ++top) {
+        const int * upper = &prefix[top * width];
+
+        for (int bottom = top; bottom < size; ++bottom) {
+            const int * lower = &prefix[(bottom + 1) * width];
+            Node * tree = band_tree(bands, top, bottom);
+
+            for (int k = 0; k < n_blocks; ++k)
+                tree[n_leaves + k] = summarize_block(upper + k * BLOCK_SIZE, lower + k * BLOCK_SIZE);
+
+            for (int i = n_leaves - 1; i >= 1; --i)
+                tree[i] = combine(tree[2 * i], tree[2 * i + 1]);
+
+            bands.best[band_index(size, top, bottom)] = tree[1].best;
+        }
+    }
+}
+
+// Add delta to cell (row, col) and update all the bands containing it
+void update_cell(
+    const int row,
+    const int col,
+    const int delta,
+    BandTrees & bands
+) {
+    const int size = bands.size;
+    const int width = bands.width;
+    const int n_leaves = bands.n_leaves;
+
+    // Column sums of rows 0 to r - 1 change for r > row
+    for (int r = row + 1; r <= size; ++r)
+        bands.prefix[r * width + col] += delta;
+
+    const int block = col / BLOCK_SIZE;
+    const int first = block * BLOCK_SIZE;
+
+    for (int top = 0; top <= row; ++top) {
+        const int * upper = &bands.prefix[top * width + first];
+
+        for (int bottom = row; bottom < size; ++bottom) {
+            const int * lower = &bands.prefix[(bottom + 1) * width + first];
+            Node * tree = band_tree(bands, top, bottom);
+
+            int i = n_leaves + block;
+            tree[i] = summarize_block(upper, lower);
+
+            for (i /= 2; i >= 1; i /= 2)
+                tree[i] = combine(tree[2 * i], tree[2 * i + 1]);
+
+            bands.best[band_index(size, top, bottom)] = tree[1].best;
+        }
+    }
+}
+
+// Current max subrectangle sum
+int max_band(const BandTrees & bands) {
+    // Empty grid
+    if (bands.best.empty())
+        return 0;
+
+    return *std::max_element(bands.best.begin(), bands.best.end());
+}
+
+// Whether x fits in an int, the type of the dynamic engine
+bool fits_int(const int64_t x) {
+    return x >= std::numeric_limits<int>::min() && x <= std::numeric_limits<int>::max();
+}
+
+int main(int argc, char * argv[])
 {
+    // Options:
+    //  --threads T  split the rows between T threads (0 uses all cores)
+    //  --dynamic    after the grid, read updates "row col value"
+    //               (0-based, the cell is set to value)
+    //               and write the max sum after each of them
+    //               Values have to fit in an int (others are rejected),
+    //               and so do the sums, as in the original problem
+    unsigned n_threads = 1;
+    bool is_dynamic = false;
+
+    for (int a = 1; a < argc; ++a) {
+        const std::string option = argv[a];
+
+        if (option == "--dynamic") {
+            is_dynamic = true;
+        }
+        else if (option == "--threads" && a + 1 < argc) {
+            n_threads = std::stoul(argv[++a]);
+            if (n_threads == 0)
+                n_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        else {
+            std::cerr << "Unknown option: " << option << "\n";
+            return 1;
+        }
+    }
+
     // Read input
     // Size of numbers square
     int size;
     std::cin >> size;
 
     // Vector to store numbers
-    std::vector<int> v(size * size);
+    // They are read as 64-bit values, the engine then stores them
+    // in the narrowest type holding them
+    std::vector<int64_t> v(size > 0 ? static_cast<size_t>(size) * size : 0);
 
     // Read and store numbers
-    for (int i = 0;; ++i) {
-        int n;
+    for (size_t i = 0; i < v.size(); ++i) {
+        int64_t n;
         std::cin >> n;
 
         if (!std::cin)
@@ -22,73 +662,60 @@ int main()
         v[i] = n;
     }
 
-    // Compute max subrectangle sum
-    int max_sum = 0;
-
-    std::vector<int> v_col(size * size);
-    for (int i = 0; i < size; ++i) {
-        int sum = 0;
-        int sub_sum = 0;
-        const int row = size * i;
+    if (is_dynamic) {
+        const int width = padded_width(size);
 
-        for (int j = 0; j < size; ++j) {         
-            // Store vector with values by columns
-            // (In v numbers are stored by rows)
-            const int new_value = v[i * size + j];
-            v_col[i + j * size] = new_value;
-
-            // Apply Kadane to each row in v
-            // This computes all the w x 1 subrectangles
-            sum += v[row + j];
-
-            if (sum < 0)
-                sum = 0;
-
-            else if (sum > sub_sum)
-                sub_sum = sum;
+        if (band_trees_bytes(size, width) > MAX_BAND_BYTES) {
+            std::cerr << "Grid too large for --dynamic: " << size << " x " << size << "\n";
+            return 1;
         }
 
-        if (sub_sum > max_sum)
-            max_sum = sub_sum;
-    }
+        // The dynamic engine works on int values
+        for (const int64_t x : v) {
+            if (!fits_int(x)) {
+                std::cerr << "Value out of the int range: " << x << "\n";
+                return 1;
+            }
+        }
 
-    // Compute all the w x h subrectangles with w >= 1, h > 1
-    for (int h = 2; h <= size; ++h) {
-        // Number of `subrectangle` rows for this size h
-        const int n_sub_rows = size - h + 1;
+        std::vector<int> grid(v.begin(), v.end());
 
-        // Rewrite v with the sums of subrectangles 1 x h
-        // Each subrectangle result is stored starting from the last row
-        const int last_row = size * (size - 1);
+        BandTrees bands;
+        build_bands(build_prefix<int, int>(grid, size, width), size, width, bands);
 
-        // Previous sums and original data in v_c
-        // are reused to compute larger subrectangles
-        // i is used to go up the column
-        for (int i = 0; i < n_sub_rows; ++i) {
-            const int row = last_row - size * i;
-             
-            int sum = 0;
-            int sub_sum = 0;
+        std::cout << max_band(bands) << "\n";
 
-            // j moves to the next subrectangle to the right        
-            for (int j = 0; j < size; ++j) {
-                v[row + j] += v_col[size - h - i + size * j];
+        for (;;) {
+            int row, col;
+            int64_t value;
+            std::cin >> row >> col >> value;
 
-                // Apply Kadane to the row of `subrectangles`
-                sum += v[row + j];
+            if (!std::cin)
+                break;
 
-                if (sum < 0)
-                    sum = 0;
+            if (row < 0 || row >= size || col < 0 || col >= size) {
+                std::cerr << "Cell out of the grid: " << row << " " << col << "\n";
+                return 1;
+            }
 
-                else if (sum > sub_sum)
-                    sub_sum = sum;
+            if (!fits_int(value)) {
+                std::cerr << "Value out of the int range: " << value << "\n";
+                return 1;
             }
 
-            if (sub_sum > max_sum)
-                max_sum = sub_sum;
+            int & cell = grid[row * size + col];
+            update_cell(row, col, static_cast<int>(value) - cell, bands);
+            cell = static_cast<int>(value);
+
+            std::cout << max_band(bands) << "\n";
         }
+
+        return 0;
     }
 
+    // Compute max subrectangle sum
+    const int64_t max_sum = max_subrectangle(v, size, n_threads);
+
     // Write output
     std::cout << max_sum << "\n";
 
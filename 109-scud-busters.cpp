@@ -3,9 +3,18 @@
 #include <ios>
 #include <vector>
 #include <algorithm>
+#include <utility>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <atomic>
 
 #define MAX_N_KINGDOMS 20
 
+// Number of missiles taken at once by a thread in --threads mode
+#define MISSILE_CHUNK 4096
+
 struct Coord {
     int x;
     int y;
@@ -20,8 +29,6 @@ struct Coord {
     }
 };
 
-using CoordIter = std::vector<Coord>::const_iterator;
-
 // Check orientation of three points, i.e.:
 // Returns:
 //      >0 if they are clockwise oriented (i.e. they turn to the right)
@@ -38,33 +45,29 @@ int orientation(const Coord & p_a, const Coord & p_b, const Coord & p_c) {
     return b.y * c.x - c.y * b.x;
 }
 
-// Function to advance to the left in a vector of coordinates
-// avoiding points already selected
-// Caller has to ensure origin is not leftmost
-CoordIter advance_left(
-    const CoordIter & origin,
-    const CoordIter & leftmost,
-    const std::vector<bool> & is_selected
-) {
-    auto current = origin - 1;
-    std::size_t index = current - leftmost;
-
-    for (;;) {
+// Read the n sites of a kingdom into `sites`
+// and order them from left to right and bottom to top
+void read_sites(const int n, std::vector<Coord> & sites) {
+    sites.resize(n);
 
-        // Break if best_guess is leftmost
-        if (current == leftmost)
-            break;
+    // There are n lines with coordinates
+    for (int i = 0; i < n; ++i) {
+        Coord coord;
+        std::cin >> coord.x >> coord.y;
 
-        // Break once a `valid` point is found
-        if (is_selected[index] == 0)
-            break;
-
-        // Try next point
-        --current;
-        --index;
+        sites[i] = coord;
     }
 
-    return current;
+    std::sort(
+        sites.begin(),
+        sites.end(),
+        [](const Coord & a, const Coord & b) {
+            if (a.x == b.x)
+                return a.y < b.y;
+            else
+                return a.x < b.x;
+        }
+    );
 }
 
 void read_input(
@@ -81,29 +84,8 @@ void read_input(
 
         // It is a kingdom
         if (n != -1) {
-            // Vector to store kingdom sites
-            std::vector<Coord> sites(n);
-
-            // There are n lines with coordinates
-            for (int i = 0; i < n; ++i) {
-                Coord coord;
-                std::cin >> coord.x >> coord.y;
-
-                sites[i] = coord;
-            }
-
-            // Order points from left to right
-            // and bottom to top
-            std::sort(
-                sites.begin(),
-                sites.end(),
-                [](const Coord & a, const Coord & b) {
-                    if (a.x == b.x)
-                        return a.y < b.y;
-                    else
-                        return a.x < b.x;
-                }
-            );
+            std::vector<Coord> sites;
+            read_sites(n, sites);
 
             kingdoms.push_back(sites);
         }
@@ -123,281 +105,528 @@ void read_input(
     }
 }
 
-void compute_upper_hull(
-    const CoordIter & leftmost,
-    const CoordIter & rightmost,
-    std::vector<bool> & is_hull,
-    std::vector<Coord> & hull
+// Compute the convex hull of `sites` with Andrew's monotone chain
+// Sites have to be ordered from left to right and bottom to top
+// The hull is written to `hull`, which must have room for 2 * n points,
+// and its number of vertices is returned
+// The hull is clockwise oriented, starting with the leftmost site:
+//      leftmost, upper hull (left to right), rightmost, lower hull (right to left)
+// Collinear sites on the border are not part of the hull
+std::size_t compute_hull(const std::vector<Coord> & sites, Coord * hull) {
+    const std::size_t n_sites = sites.size();
+
+    if (n_sites < 2) {
+        std::copy(sites.begin(), sites.end(), hull);
+        return n_sites;
+    }
+
+    // Number of vertices in the hull buffer
+    std::size_t k = 0;
+
+    // Upper hull, from leftmost to rightmost
+    // Going clockwise every vertex has to turn to the right,
+    // previous vertices are dropped while the turn is to the left
+    // or the points are collinear
+    for (std::size_t i = 0; i < n_sites; ++i) {
+        while (k >= 2 && orientation(hull[k - 2], hull[k - 1], sites[i]) <= 0)
+            --k;
+
+        hull[k++] = sites[i];
+    }
+
+    // Lower hull, from rightmost back to leftmost
+    // Vertices of the upper hull are never dropped
+    const std::size_t upper_end = k + 1;
+
+    for (std::size_t i = n_sites - 1; i-- > 0;) {
+        while (k >= upper_end && orientation(hull[k - 2], hull[k - 1], sites[i]) <= 0)
+            --k;
+
+        hull[k++] = sites[i];
+    }
+
+    // Leftmost site is found again at the end
+    return k - 1;
+}
+
+// Kingdom data needed to process missiles
+struct Kingdom {
+    // Border (convex hull), clockwise oriented
+    std::vector<Coord> hull;
+
+    // Two times the area inside the border
+    int twice_area;
+
+    // Bounding box of the border
+    Coord low;
+    Coord high;
+};
+
+// Build kingdom data from its ordered sites
+// `buffer` is used for the hull computation (see compute_hull)
+void build_kingdom(
+    const std::vector<Coord> & sites,
+    std::vector<Coord> & buffer,
+    Kingdom & kingdom
 ) {
-    // First point of upper hull is the leftmost-bottom  
-    hull.push_back(*leftmost);
-    is_hull[0] = true;
+    const std::size_t n_hull = compute_hull(sites, buffer.data());
+    kingdom.hull.assign(buffer.begin(), buffer.begin() + n_hull);
 
-    // Position of last point found to be in the hull
-    auto last = leftmost;
+    const std::vector<Coord> & hull = kingdom.hull;
 
-    // End iterator of sites vector
-    const auto end = rightmost + 1;
+    // Area computation is based on shoelace formula,
+    // optimized to have fewer multiplications
+    // Hull is clockwise oriented by construction
+    // Signs are chosen to provide a positive value
+    kingdom.twice_area = 0;
+    for (std::size_t j = 0; j < n_hull; ++j) {
+        const Coord & previous = hull[j == 0 ? n_hull - 1 : j - 1];
+        const Coord & next = hull[j + 1 == n_hull ? 0 : j + 1];
 
-    for (;;) {
-        // There are at least three points in the kingdom
-        // Next point to the right is the initial best guess in this iteration
-        auto best_guess = last + 1;
+        kingdom.twice_area += hull[j].x * (previous.y - next.y);
+    }
 
-        // Point to be checked at the iteration
-        // Current points will always be more to the right
-        // than in previous iterations
-        auto current = best_guess + 1;
+    // Sites are ordered by x, the hull gives the y range
+    kingdom.low = {sites.front().x, sites.front().y};
+    kingdom.high = {sites.back().x, sites.back().y};
 
-        // Check all other sites
-        for (;;) {
-            // Break when end iterator is reached
-            if (current == end)
-                break;
+    for (const Coord & vertex : hull) {
+        kingdom.low.y = std::min(kingdom.low.y, vertex.y);
+        kingdom.high.y = std::max(kingdom.high.y, vertex.y);
+    }
+}
 
-            // Update best_guess if a point is found such that
-            // the line last->current is to the LEFT of last->best_guess
-            // or if they are collinear
-            if (orientation(*last, *best_guess, *current) <= 0)
-                best_guess = current;
+// Check if a missile is inside the kingdom border (the border counts as inside)
+// The hull is seen as a fan of triangles from hull[0]:
+// a binary search finds the triangle whose wedge contains the missile,
+// then only the border edge of that triangle is checked, in O(log h)
+bool is_inside(const Kingdom & kingdom, const Coord & missile) {
+    if (missile.x < kingdom.low.x || missile.x > kingdom.high.x ||
+        missile.y < kingdom.low.y || missile.y > kingdom.high.y)
+        return false;
+
+    const std::vector<Coord> & hull = kingdom.hull;
+    const std::size_t n_hull = hull.size();
+
+    if (n_hull < 3) {
+        // Degenerate border: a point or a segment
+        // (the bounding box already bounds the missile)
+        return n_hull > 0 && orientation(hull[0], hull.back(), missile) == 0;
+    }
 
-            // Advance
-            ++current;
+    // Hull is ordered clockwise, so the missile has to be to the right
+    // of the first edge and to the left of the line to the last vertex
+    const Coord & origin = hull[0];
+    if (orientation(origin, hull[1], missile) < 0 ||
+        orientation(origin, hull[n_hull - 1], missile) > 0)
+        return false;
+
+    // Find the last vertex with the missile to the right of (or on)
+    // the line from the origin to it
+    std::size_t lo = 1;
+    std::size_t hi = n_hull - 1;
+
+    while (hi - lo > 1) {
+        const std::size_t mid = (lo + hi) / 2;
+
+        if (orientation(origin, hull[mid], missile) >= 0)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    // Missile is inside the wedge between lo and lo + 1,
+    // check the border edge closing it
+    return orientation(hull[lo], hull[lo + 1], missile) >= 0;
+}
+
+// Uniform grid over the bounding box of all kingdoms
+// Each cell lists the kingdoms whose bounding box overlaps it,
+// so a missile only checks the kingdoms of its cell
+// Kingdoms hit by a missile are flagged, and removed from a cell list
+// (swapping with the last entry) the next time the cell is visited
+struct KingdomIndex {
+    // Lowest corner of the grid
+    Coord origin;
+
+    // Size of a cell
+    int64_t cell_width;
+    int64_t cell_height;
+
+    // Number of cells in each direction
+    int n_cols;
+    int n_rows;
+
+    // Kingdom indices of each cell, by rows
+    std::vector<std::vector<std::size_t>> cells;
+
+    // Whether each kingdom has already been hit
+    std::vector<bool> is_hit;
+};
+
+// Build index over the kingdoms, with about one kingdom per cell
+void build_index(const std::vector<Kingdom> & kingdoms, KingdomIndex & index) {
+    const std::size_t n_kingdoms = kingdoms.size();
+
+    index.is_hit.assign(n_kingdoms, false);
+
+    if (n_kingdoms == 0) {
+        index.origin = {0, 0};
+        index.cell_width = index.cell_height = 1;
+        index.n_cols = index.n_rows = 0;
+        index.cells.clear();
+        return;
+    }
+
+    // Bounding box of all kingdoms
+    Coord low = kingdoms[0].low;
+    Coord high = kingdoms[0].high;
+
+    for (const Kingdom & kingdom : kingdoms) {
+        low.x = std::min(low.x, kingdom.low.x);
+        low.y = std::min(low.y, kingdom.low.y);
+        high.x = std::max(high.x, kingdom.high.x);
+        high.y = std::max(high.y, kingdom.high.y);
+    }
+
+    const int side = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(n_kingdoms))));
+    const int64_t width = static_cast<int64_t>(high.x) - low.x + 1;
+    const int64_t height = static_cast<int64_t>(high.y) - low.y + 1;
+
+    index.origin = low;
+    index.cell_width = (width + side - 1) / side;
+    index.cell_height = (height + side - 1) / side;
+    index.n_cols = static_cast<int>((width + index.cell_width - 1) / index.cell_width);
+    index.n_rows = static_cast<int>((height + index.cell_height - 1) / index.cell_height);
+    index.cells.assign(static_cast<std::size_t>(index.n_cols) * index.n_rows, {});
+
+    for (std::size_t k = 0; k < n_kingdoms; ++k) {
+        const Kingdom & kingdom = kingdoms[k];
+
+        const int col_lo = static_cast<int>((kingdom.low.x - low.x) / index.cell_width);
+        const int col_hi = static_cast<int>((kingdom.high.x - low.x) / index.cell_width);
+        const int row_lo = static_cast<int>((kingdom.low.y - low.y) / index.cell_height);
+        const int row_hi = static_cast<int>((kingdom.high.y - low.y) / index.cell_height);
+
+        for (int row = row_lo; row <= row_hi; ++row)
+            for (int col = col_lo; col <= col_hi; ++col)
+                index.cells[static_cast<std::size_t>(row) * index.n_cols + col].push_back(k);
+    }
+}
+
+// Cell of the index containing a missile
+// (the number of cells if it is outside the grid)
+std::size_t find_cell(const KingdomIndex & index, const Coord & missile) {
+    const std::size_t none = index.cells.size();
+
+    const int64_t dx = static_cast<int64_t>(missile.x) - index.origin.x;
+    const int64_t dy = static_cast<int64_t>(missile.y) - index.origin.y;
+
+    if (dx < 0 || dy < 0)
+        return none;
+
+    const int64_t col = dx / index.cell_width;
+    const int64_t row = dy / index.cell_height;
+
+    if (col >= index.n_cols || row >= index.n_rows)
+        return none;
+
+    return row * index.n_cols + col;
+}
+
+// Find the kingdom hit by a missile, if it was not already hit
+// The kingdom is flagged and its index returned,
+// otherwise the number of kingdoms is returned
+std::size_t hit_kingdom(
+    const std::vector<Kingdom> & kingdoms,
+    const Coord & missile,
+    KingdomIndex & index
+) {
+    const std::size_t none = kingdoms.size();
+
+    const std::size_t c = find_cell(index, missile);
+    if (c == index.cells.size())
+        return none;
+
+    std::vector<std::size_t> & cell = index.cells[c];
+
+    for (std::size_t i = 0; i < cell.size();) {
+        const std::size_t k = cell[i];
+
+        // Drop kingdoms already hit
+        if (index.is_hit[k]) {
+            cell[i] = cell.back();
+            cell.pop_back();
+            continue;
         }
 
-        // Check if rightmost point is reached
-        // This point is not pushed back to upper hull,
-        // since it will be the first point of lower hull
-        if (best_guess == rightmost)
-            break;
+        if (is_inside(kingdoms[k], missile)) {
+            index.is_hit[k] = true;
+
+            cell[i] = cell.back();
+            cell.pop_back();
 
-        // Otherwise introduce the point found
-        last = best_guess;
-        const std::size_t index = best_guess - leftmost;
-        is_hull[index] = true;
-        hull.push_back(*best_guess);
+            // Kingdoms do not overlap
+            return k;
+        }
+
+        ++i;
     }
+
+    return none;
 }
 
-void compute_lower_hull(
-    const CoordIter & leftmost,
-    const CoordIter & rightmost,
-    std::vector<bool> & is_hull,
-    std::vector<Coord> & hull
+// Find the kingdom containing a missile, without changing the index
+// (kingdoms already hit are still found)
+// Returns the number of kingdoms if there is none
+std::size_t find_kingdom(
+    const std::vector<Kingdom> & kingdoms,
+    const Coord & missile,
+    const KingdomIndex & index
 ) {
-    // First point will be the rightmost site
-    hull.push_back(*rightmost);
-    is_hull.back() = true;
+    const std::size_t none = kingdoms.size();
 
-    // Position of last point found to be in the hull
-    auto last = rightmost;
+    const std::size_t c = find_cell(index, missile);
+    if (c == index.cells.size())
+        return none;
 
-    for (;;) {
-        // Next point to the left is the initial best guess in this iteration
-        // that is not already in the hull
-        // `last` is never leftmost
-        auto best_guess = advance_left(last, leftmost, is_hull);
+    for (const std::size_t k : index.cells[c])
+        if (is_inside(kingdoms[k], missile))
+            return k;
 
-        // Break if best_guess is leftmost
-        if (best_guess == leftmost)
-            break;
+    return none;
+}
+
+// Run f(t) for t = 0 to n_threads - 1, each in its own thread
+// (f(0) runs in the calling thread)
+template <typename F>
+void run_threads(const unsigned n_threads, F f) {
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < n_threads; ++t)
+        threads.emplace_back(f, t);
+
+    f(0);
+
+    for (std::thread & thread : threads)
+        thread.join();
+}
+
+// Build the data of all kingdoms using n_threads threads
+// Kingdoms are handed out with an atomic counter,
+// each thread has its own hull buffer
+void build_kingdoms(
+    const std::vector<std::vector<Coord>> & sites,
+    const unsigned n_threads,
+    std::vector<Kingdom> & kingdoms
+) {
+    const std::size_t n_kingdoms = sites.size();
+    kingdoms.resize(n_kingdoms);
+
+    // Buffer size for the hull computation, large enough for any kingdom
+    std::size_t max_sites = 0;
+    for (const std::vector<Coord> & kingdom_sites : sites)
+        max_sites = std::max(max_sites, kingdom_sites.size());
 
-        // Point to be checked at the iteration
-        // Current points will always be more to the left
-        // than in previous iterations
-        // `best_guess` is not leftmost
-        auto current = advance_left(best_guess, leftmost, is_hull);
+    std::atomic<std::size_t> next(0);
+
+    run_threads(n_threads, [&](unsigned) {
+        std::vector<Coord> buffer(2 * max_sites);
 
-        // Check all other sites
         for (;;) {
-            // Update best_guess if a point is found such that
-            // the line last->current is to the LEFT of last->best_guess
-            // or collinear
-            if (orientation(*last, *best_guess, *current) <= 0)
-                best_guess = current;
-
-            // Break when leftmost point is reached
-            // This is checked after the orientation to avoid
-            // keeping as "best_guess" the initial point, which
-            // would not be checked otherwise
-            if (current == leftmost)
+            const std::size_t k = next.fetch_add(1, std::memory_order_relaxed);
+            if (k >= n_kingdoms)
                 break;
 
-            // Advance until new current point is not already on the hull
-            // `current` is not leftmost
-            current = advance_left(current, leftmost, is_hull);
+            build_kingdom(sites[k], buffer, kingdoms[k]);
         }
+    });
+}
 
-        // Check if leftmost point is reached
-        // and so the hull is closed
-        if (best_guess == leftmost)
-            break;
+// Two times the total area of the kingdoms hit by the missiles,
+// using n_threads threads
+// Chunks of MISSILE_CHUNK missiles are handed out with an atomic counter,
+// hit kingdoms are marked in a shared bitmap with atomic OR
+// Areas are summed once at the end, in kingdom order
+// (integer sums, thus the same result as the serial path)
+int impact_parallel(
+    const std::vector<Kingdom> & kingdoms,
+    const std::vector<Coord> & missiles,
+    const KingdomIndex & index,
+    const unsigned n_threads
+) {
+    const std::size_t n_kingdoms = kingdoms.size();
+    const std::size_t n_missiles = missiles.size();
 
-        // Otherwise introduce the point found
-        last = best_guess;
-        const std::size_t index = best_guess - leftmost;
-        is_hull[index] = true;
-        hull.push_back(*best_guess);
-    }
+    std::vector<std::atomic<uint64_t>> is_hit((n_kingdoms + 63) / 64);
+    for (std::atomic<uint64_t> & word : is_hit)
+        word.store(0, std::memory_order_relaxed);
+
+    std::atomic<std::size_t> next(0);
+
+    run_threads(n_threads, [&](unsigned) {
+        for (;;) {
+            const std::size_t first = next.fetch_add(MISSILE_CHUNK, std::memory_order_relaxed);
+            if (first >= n_missiles)
+                break;
+
+            const std::size_t last = std::min(first + MISSILE_CHUNK, n_missiles);
+
+            for (std::size_t i = first; i < last; ++i) {
+                const std::size_t k = find_kingdom(kingdoms, missiles[i], index);
+                if (k == n_kingdoms)
+                    continue;
+
+                const uint64_t bit = uint64_t(1) << (k % 64);
+                std::atomic<uint64_t> & word = is_hit[k / 64];
+
+                // Avoid writing the shared word once the kingdom is marked
+                if ((word.load(std::memory_order_relaxed) & bit) == 0)
+                    word.fetch_or(bit, std::memory_order_relaxed);
+            }
+        }
+    });
+
+    // Threads have been joined, all marks are visible
+    int twice_total_area = 0;
+    for (std::size_t k = 0; k < n_kingdoms; ++k)
+        if (is_hit[k / 64].load(std::memory_order_relaxed) >> (k % 64) & 1)
+            twice_total_area += kingdoms[k].twice_area;
+
+    return twice_total_area;
 }
 
-int main()
-{
-    // Vector of vectors with kingdom's points
-    std::vector<std::vector<Coord>> kingdoms;
+// Process the input as it is read (--stream)
+// The border of each kingdom is built as soon as its sites are read,
+// and only the kingdom data is kept
+// Once the missiles start (-1) the index is built, and each missile
+// is processed as it is read: whenever it hits a new kingdom,
+// the running area without power is written
+// The last line written is the total area, as in the batch mode
+void run_stream() {
+    std::vector<Kingdom> kingdoms;
     kingdoms.reserve(MAX_N_KINGDOMS);
 
-    // Vector with missile coordinates
-    std::vector<Coord> missiles;
+    // Buffers reused for all kingdoms
+    std::vector<Coord> sites;
+    std::vector<Coord> buffer;
 
-    read_input(kingdoms, missiles);
+    std::cout << std::fixed;
+    std::cout << std::setprecision(2);
 
-    // Number of missiles
-    const std::size_t n_missiles = missiles.size();
+    // Unknown number of kingdoms
+    for (;;) {
+        int n;
+        std::cin >> n;
 
-    // Number of kingdoms
-    const std::size_t n_kingdoms = kingdoms.size();
+        if (!std::cin || n == -1)
+            break;
 
-    // Compute border of each kingdom
-    std::vector<std::vector<Coord>> borders(n_kingdoms);
+        read_sites(n, sites);
 
-    for (std::size_t k = 0; k < n_kingdoms; ++k) {
-        // `sites` vector is const,
-        // thus iterators usage below is safe
-        const std::vector<Coord> sites = kingdoms[k];
-        const std::size_t n_sites = sites.size();
-
-        // Find border (convex hull) around each kingdom
-        std::vector<Coord> hull;
-        hull.reserve(n_sites);
-
-        // Vector to indicate if a point is on the hull
-        std::vector<bool> is_hull(n_sites, false);
-
-        // Leftmost(-bottom) and rightmost(-top) points
-        // (Sites vector is ordered)
-        const auto leftmost = sites.begin();
-        const auto rightmost = sites.end() - 1;
-
-        compute_upper_hull(
-            leftmost, rightmost,
-            is_hull, hull
-        );
-
-        compute_lower_hull(
-            leftmost, rightmost,
-            is_hull, hull
-        );
-
-        borders[k] = hull;
+        if (buffer.size() < 2 * sites.size())
+            buffer.resize(2 * sites.size());
+
+        kingdoms.emplace_back();
+        build_kingdom(sites, buffer, kingdoms.back());
     }
 
+    const std::size_t n_kingdoms = kingdoms.size();
+
+    KingdomIndex index;
+    build_index(kingdoms, index);
+
     // Two times the total area of the kingdoms without power
     int twice_total_area = 0;
 
-    // Find which kingdoms have missile impacts
-    for (std::size_t i = 0; i < n_missiles; ++i) {
-        const Coord missile = missiles[i];
-
-        for (std::size_t k = 0; k < borders.size(); ++k) {
-            const std::vector<Coord> hull = borders[k];
-
-            // Number of vertices in the hull
-            const std::size_t n_hull = hull.size();
-
-            // Missile has to be at least 
-            // between leftmost and rightmost sites
-            const Coord leftmost_point = hull[0];
-            const Coord rightmost_point = kingdoms[k].back();
-
-            // This will count missiles that impact on border
-            if (missile.x < leftmost_point.x || missile.x > rightmost_point.x)
-                continue;
-
-            // If missile is between leftmost and rightmost points,
-            // go over border edges to check if missile
-            // is inside kingdom and compute (2x)area
-            int twice_area = 0;
-
-            // Area computation is based on shoelace formula,
-            // optimized to have fewer multiplications
-            // Sum from j = 1 to j = n - 2
-            Coord previous = hull[0];
-            Coord current = hull[1];
-            Coord next;
-
-            // Bool to track if missile is found for this kingdom
-            // Missile is assumed to be found at this point,
-            // looping over the hull edges will check it
-            bool is_inside = true;
-
-            // Loop over the first n - 2 edges
-            std::size_t j = 1;
-            for (; j < n_hull - 1;) {
-                // Hull is ordered clockwise, so a missile
-                // is inside if it is to the right of all the edges
-                // Set is_inside to 0 and break as soon as
-                // the missile is found to be to the left (i.e. it is outside)
-                if (orientation(hull[j - 1], hull[j], missile) < 0) {
-                    is_inside = false;
-                    break;
-                }
+    // Unknown number of lines
+    // with missile coordinates
+    for (;;) {
+        Coord missile;
+        std::cin >> missile.x >> missile.y;
 
-                // Compute next area term
-                next = hull[j + 1];
+        if (!std::cin)
+            break;
 
-                // Hull is clockwise oriented by construction
-                // Signs are chosen to provide a positive value
-                twice_area += current.x * (previous.y - next.y);
+        const std::size_t k = hit_kingdom(kingdoms, missile, index);
+        if (k == n_kingdoms)
+            continue;
 
-                previous = current;
-                current = next;
-                ++j;
-            }
+        twice_total_area += kingdoms[k].twice_area;
 
-            // Go to next kingdom if it was found to be outside
-            if (!is_inside)
-                continue;
+        // Flushed, so results are available before the input ends
+        std::cout << 1.0 / 2.0 * twice_total_area << std::endl;
+    }
 
-            // Check the last two edges
+    // Final area, also written if no kingdom was hit
+    std::cout << 1.0 / 2.0 * twice_total_area << "\n";
+}
 
-            // j = n - 1 (nth vertex is hull[0])
-            // Check edge between vertices n - 2 and n - 1
-            if (orientation(hull[j - 1], hull[j], missile) < 0) {
-                // If outside, look in next kingdom
-                continue;
-            }
-            else {
-                next = hull[0];
-                twice_area += current.x * (previous.y - next.y);
+int main(int argc, char * argv[])
+{
+    // Options:
+    //  --threads T  compute hulls and process missiles with T threads
+    //               (0 uses all cores)
+    //  --stream     build each border as soon as its kingdom is read,
+    //               process missiles as they are read and write
+    //               the area each time a new kingdom is hit
+    unsigned n_threads = 1;
+    bool is_stream = false;
+
+    for (int a = 1; a < argc; ++a) {
+        const std::string option = argv[a];
+
+        if (option == "--stream") {
+            is_stream = true;
+        }
+        else if (option == "--threads" && a + 1 < argc) {
+            n_threads = std::stoul(argv[++a]);
+            if (n_threads == 0)
+                n_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        else {
+            std::cerr << "Unknown option: " << option << "\n";
+            return 1;
+        }
+    }
 
-                previous = current;
-                current = next;
-                ++j;
-            }
+    if (is_stream) {
+        run_stream();
+        return 0;
+    }
+
+    // Vector of vectors with kingdom's points
+    std::vector<std::vector<Coord>> sites;
+    sites.reserve(MAX_N_KINGDOMS);
+
+    // Vector with missile coordinates
+    std::vector<Coord> missiles;
 
-            // j = n (nth vertex is hull[0], n+1th vertex is hull[1])
-            // Check edge between vertices n - 2 and n - 1
-            // (Last edge: condition is inverted to finish area computation)
-            if (orientation(hull[j - 1], hull[0], missile) >= 0) {
+    read_input(sites, missiles);
 
-                next = hull[1];
-                twice_area += current.x * (previous.y - next.y);
+    // Number of kingdoms
+    const std::size_t n_kingdoms = sites.size();
+
+    // Compute border of each kingdom
+    std::vector<Kingdom> kingdoms;
+    build_kingdoms(sites, n_threads, kingdoms);
 
-                twice_total_area += twice_area;
+    // Index to find the kingdoms around each missile
+    KingdomIndex index;
+    build_index(kingdoms, index);
 
-                // Remove kingdom data if it already has a missile impact
-                // (Last element of the vectors will occupy the kingdom's position)
-                kingdoms[k] = kingdoms.back();
-                kingdoms.pop_back();
+    // Two times the total area of the kingdoms without power
+    int twice_total_area = 0;
 
-                borders[k] = borders.back();
-                borders.pop_back();
+    if (n_threads > 1) {
+        twice_total_area = impact_parallel(kingdoms, missiles, index, n_threads);
+    }
+    else {
+        // Find which kingdoms have missile impacts
+        for (const Coord & missile : missiles) {
+            const std::size_t k = hit_kingdom(kingdoms, missile, index);
 
-                // Stop looking in the kingdoms if missile 
-                // has already been found (kingdoms do not overlap)
-                break;
-            }
+            if (k < n_kingdoms)
+                twice_total_area += kingdoms[k].twice_area;
         }
     }
 
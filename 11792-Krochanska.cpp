@@ -4,13 +4,797 @@
 #include <vector>
 #include <algorithm>
 #include <utility>
+#include <climits>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+// The AVX2 kernel is only built with GCC-compatible compilers on x86,
+// it is selected at runtime if the CPU supports it
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_AVX2_KERNEL 1
+#include <immintrin.h>
+#endif
 
 #define MAX_N_STATIONS 10000
 #define MAX_N_IMPORTANT 1000
 #define MAX_N_LINES 100
 
-int main()
+// Number of int values in a vector register
+// Rows of the distances matrix are padded to a multiple of it
+#define LANES 8
+
+// Number of nodes per side of a tile in Floyd
+// (a tile of ints takes 16 KB)
+#define TILE_SIZE 64
+
+// Fraction of pairs of important stations joined by an edge
+// from which Floyd is used instead of a search from each station
+#define DENSE_THRESHOLD 0.05
+
+// Edge of the simplified graph
+// between `consecutive` important stations of a line
+// (a and b are indices in the `important` vector)
+struct Edge {
+    int a;
+    int b;
+    int steps;
+};
+
+// Simplified graph in compressed sparse row form:
+// neighbours of node s are targets[offsets[s]] to targets[offsets[s + 1] - 1],
+// with the same positions in weights
+// Edges are stored in both directions
+struct Graph {
+    int n_nodes;
+    int max_weight;
+    std::vector<int> offsets;
+    std::vector<int> targets;
+    std::vector<int> weights;
+};
+
+// Read the stations of n_lines lines and count
+// the number of times each station is found
+// (if count > 1 the station is important)
+// (lines never repeat stations)
+void read_lines(
+    const int n_lines,
+    std::vector<std::vector<int>> & lines,
+    std::vector<int> & counts
+) {
+    for (int l = 0; l < n_lines; ++l) {
+        std::vector<int> stations_read;
+
+        for (;;) {
+            int station;
+            std::cin >> station;
+
+            if (!station)
+                // When 0 is read it stops reading line
+                // 0 is not introduced in the line vector
+                break;
+            stations_read.push_back(station);
+
+            // Update count value for the station
+            ++counts[station - 1];
+        }
+
+        lines.push_back(stations_read);
+    }
+}
+
+// Simplify graph by retaining only the important stations as nodes
+// Important stations are stored in increasing order in v_important,
+// and order_important stores their order (important_station =
+// v_important[order_important - 1]), or 0 for non-important stations
+void find_important(
+    const std::vector<int> & counts,
+    std::vector<int> & v_important,
+    std::vector<int> & order_important
+) {
+    int order = 0;
+
+    for (std::size_t s = 0; s < counts.size(); ++s) {
+        if (counts[s] > 1) {
+            const int station = s + 1;
+            v_important.push_back(station);
+
+            // Update `order count`
+            ++order;
+
+            // Store number for this station
+            order_important[s] = order;
+        }
+    }
+}
+
+// Look for pairs of `consecutive` important stations in each line
+// Each pair found is an edge, weighted with the steps between them
+// (a pair can be repeated in different lines)
+void find_edges(
+    const std::vector<std::vector<int>> & lines,
+    const std::vector<int> & order_important,
+    std::vector<Edge> & edges
+) {
+    for (std::size_t l = 0; l < lines.size(); ++l) {
+        // Count of edges between `consecutive` important stations
+        int steps = 0;
+
+        // Pair to store `consecutive` important stations
+        std::pair<int, int> found = {0, 0};
+
+        // Vector of stations in the line
+        const std::vector<int> & stations = lines[l];
+
+        // Loop over stations in each line
+        for (std::size_t s = 0; s < stations.size(); ++s) {
+            // Station number
+            const int station = stations[s];
+
+            // Check if station is important
+            if (order_important[station - 1] > 0) {
+                // If the station is the first of the first pair
+                if (found.first == 0) {
+                    found.first = station;
+                }
+                else {
+                    // The station is not the first one found,
+                    // thus it will be the second of a pair
+                    found.second = station;
+
+                    // Equivalent indeces in the `important` vector
+                    const int a = order_important[found.first - 1] - 1;
+                    const int b = order_important[found.second - 1] - 1;
+
+                    edges.push_back({a, b, steps});
+
+                    // The station found will be the first of a pair
+                    // (if it can be completed before ending the line)
+                    found.first = station;
+
+                    // Reinitialize steps for the next pair
+                    steps = 0;
+                }
+            }
+
+            // If a pair has already been started
+            // update steps before advancing to next station
+            if (found.first != 0)
+                ++steps;
+        }
+    }
+}
+
+// Build the compressed sparse row graph from the edges
+void build_graph(
+    const int n_nodes,
+    const std::vector<Edge> & edges,
+    Graph & graph
+) {
+    graph.n_nodes = n_nodes;
+    graph.max_weight = 0;
+    graph.offsets.assign(n_nodes + 1, 0);
+    graph.targets.resize(2 * edges.size());
+    graph.weights.resize(2 * edges.size());
+
+    // Count neighbours of each node, then turn counts into offsets
+    for (const Edge & edge : edges) {
+        ++graph.offsets[edge.a + 1];
+        ++graph.offsets[edge.b + 1];
+        graph.max_weight = std::max(graph.max_weight, edge.steps);
+    }
+
+    for (int s = 0; s < n_nodes; ++s)
+        graph.offsets[s + 1] += graph.offsets[s];
+
+    // Fill neighbours, `next` is the next free position of each node
+    std::vector<int> next(graph.offsets.begin(), graph.offsets.end() - 1);
+
+    for (const Edge & edge : edges) {
+        graph.targets[next[edge.a]] = edge.b;
+        graph.weights[next[edge.a]++] = edge.steps;
+
+        graph.targets[next[edge.b]] = edge.a;
+        graph.weights[next[edge.b]++] = edge.steps;
+    }
+}
+
+// Distances between important stations, stored by rows in a single array
+// dist[s * stride + t], s (t) index corresponds to v_important[s]
+// Rows are padded to a multiple of LANES, so vector kernels
+// never need a scalar tail (padding values are never read as distances)
+struct DistanceMatrix {
+    int n;
+    int stride;
+    std::vector<int> dist;
+};
+
+// Fill the matrix with the edge weights
+// In order to keep always a minimum value
+// distances will be initialized to a
+// maximum path (n_stations - 1)
+// (edges in full graph count always as 1)
+void init_matrix(
+    const int n_important,
+    const std::vector<Edge> & edges,
+    const int n_stations,
+    DistanceMatrix & matrix
+) {
+    matrix.n = n_important;
+    matrix.stride = (n_important + LANES - 1) / LANES * LANES;
+    matrix.dist.assign(static_cast<std::size_t>(n_important) * matrix.stride, n_stations - 1);
+
+    int * dist = matrix.dist.data();
+    const std::size_t stride = matrix.stride;
+
+    // Distance between the same station is zero
+    for (int s = 0; s < n_important; ++s)
+        dist[s * stride + s] = 0;
+
+    // If a pair is repeated in a different line,
+    // the minimum path is kept
+    for (const Edge & edge : edges) {
+        if (edge.steps < dist[edge.a * stride + edge.b]) {
+            // Graph is unordered
+            dist[edge.a * stride + edge.b] = edge.steps;
+            dist[edge.b * stride + edge.a] = edge.steps;
+        }
+    }
+}
+
+// Kernels relaxing the block of rows [s_begin, s_end)
+// and columns [t_begin, t_end) through the intermediate nodes [k_begin, k_end):
+//      dist[s][t] = min(dist[s][t], dist[s][k] + dist[k][t])
+// Column limits have to be multiples of LANES
+using BlockKernel = void (*)(
+    int * dist, std::size_t stride,
+    int k_begin, int k_end,
+    int s_begin, int s_end,
+    int t_begin, int t_end
+);
+
+void relax_block_scalar(
+    int * dist, const std::size_t stride,
+    const int k_begin, const int k_end,
+    const int s_begin, const int s_end,
+    const int t_begin, const int t_end
+) {
+    for (int k = k_begin; k < k_end; ++k) {
+        const int * row_k = dist + k * stride;
+
+        for (int s = s_begin; s < s_end; ++s) {
+            int * row_s = dist + s * stride;
+            const int distance_sk = row_s[k];
+
+            for (int t = t_begin; t < t_end; ++t)
+                row_s[t] = std::min(row_s[t], distance_sk + row_k[t]);
+        }
+    }
+}
+
+#ifdef HAVE_AVX2_KERNEL
+__attribute__((target("avx2")))
+void relax_block_avx2(
+    int * dist, const std::size_t stride,
+    const int k_begin, const int k_end,
+    const int s_begin, const int s_end,
+    const int t_begin, const int t_end
+) {
+    for (int k = k_begin; k < k_end; ++k) {
+        const int * row_k = dist + k * stride;
+
+        for (int s = s_begin; s < s_end; ++s) {
+            int * row_s = dist + s * stride;
+            const __m256i distance_sk = _mm256_set1_epi32(row_s[k]);
+
+            for (int t = t_begin; t < t_end; t += LANES) {
+                __m256i * target = reinterpret_cast<__m256i *>(row_s + t);
+                const __m256i through_k = _mm256_add_epi32(
+                    distance_sk,
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row_k + t))
+                );
+
+                _mm256_storeu_si256(target, _mm256_min_epi32(_mm256_loadu_si256(target), through_k));
+            }
+        }
+    }
+}
+#endif
+
+// Choose the kernel supported by the CPU
+BlockKernel select_kernel() {
+#ifdef HAVE_AVX2_KERNEL
+    if (__builtin_cpu_supports("avx2"))
+        return relax_block_avx2;
+#endif
+
+    return relax_block_scalar;
+}
+
+// Run f(t) for t = 0 to n_threads - 1, each in its own thread
+// (f(0) runs in the calling thread)
+template <typename F>
+void run_threads(const unsigned n_threads, F f) {
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < n_threads; ++t)
+        threads.emplace_back(f, t);
+
+    f(0);
+
+    for (std::thread & thread : threads)
+        thread.join();
+}
+
+// Reusable barrier for the threads of a computation
+// Each round is identified by `generation`
+struct Barrier {
+    std::mutex mutex;
+    std::condition_variable changed;
+    unsigned n_threads;
+    unsigned n_waiting;
+    unsigned generation;
+};
+
+// Wait until all threads reach the barrier
+void wait_all(Barrier & barrier) {
+    std::unique_lock<std::mutex> lock(barrier.mutex);
+    const unsigned generation = barrier.generation;
+
+    if (++barrier.n_waiting == barrier.n_threads) {
+        barrier.n_waiting = 0;
+        ++barrier.generation;
+        barrier.changed.notify_all();
+        return;
+    }
+
+    barrier.changed.wait(lock, [&]() { return barrier.generation != generation; });
+}
+
+// Compute minimum paths between
+// pairs of important stations, and the sum of each row
+// Floyd is applied on simplified graph, by tiles of TILE_SIZE nodes
+// For each block of intermediate nodes kb:
+//  1. the diagonal tile (kb, kb) is relaxed on its own
+//  2. tiles in row kb and column kb are relaxed with the diagonal tile
+//  3. all other tiles are relaxed with the tiles of row and column kb
+// so each phase works on a few tiles that fit in cache
+// Tiles of phases 2 and 3 are independent, they are split between
+// n_threads threads (tile i to thread i % n_threads), with a barrier
+// after each phase
+// Every tile is relaxed once with the last block of intermediate nodes,
+// and is final afterwards: its rows are then added to per-thread sums,
+// so no second pass over the matrix is needed
+void floyd_tiled(
+    DistanceMatrix & matrix,
+    const unsigned n_threads,
+    std::vector<int> & sums
+) {
+    const BlockKernel relax_block = select_kernel();
+
+    const int n = matrix.n;
+    int * dist = matrix.dist.data();
+    const std::size_t stride = matrix.stride;
+
+    // Tiles cover all rows, and all columns including padding
+    const int n_tiles = (matrix.stride + TILE_SIZE - 1) / TILE_SIZE;
+    const int n_row_tiles = (n + TILE_SIZE - 1) / TILE_SIZE;
+    const auto begin = [](const int tile) { return tile * TILE_SIZE; };
+    const auto end = [&](const int tile, const int limit) {
+        return std::min((tile + 1) * TILE_SIZE, limit);
+    };
+
+    std::vector<std::vector<int>> thread_sums(n_threads, std::vector<int>(n, 0));
+
+    Barrier barrier;
+    barrier.n_threads = n_threads;
+    barrier.n_waiting = 0;
+    barrier.generation = 0;
+
+    run_threads(n_threads, [&](const unsigned thread) {
+        std::vector<int> & local_sums = thread_sums[thread];
+
+        // Relax tile (sb, tb) with the intermediate nodes of kb,
+        // and add it to the sums if kb is the last block
+        const auto relax_tile = [&](const int kb, const int sb, const int tb) {
+            const int s_begin = begin(sb);
+            const int s_end = end(sb, n);
+
+            relax_block(
+                dist, stride,
+                begin(kb), end(kb, n),
+                s_begin, s_end,
+                begin(tb), end(tb, stride)
+            );
+
+            if (kb != n_row_tiles - 1)
+                return;
+
+            const int t_end = end(tb, n);
+            for (int s = s_begin; s < s_end; ++s)
+                for (int t = begin(tb); t < t_end; ++t)
+                    local_sums[s] += dist[s * stride + t];
+        };
+
+        for (int kb = 0; kb < n_row_tiles; ++kb) {
+            // Phase 1
+            if (thread == 0)
+                relax_tile(kb, kb, kb);
+
+            wait_all(barrier);
+
+            // Phase 2
+            unsigned tile = 0;
+            for (int b = 0; b < n_tiles; ++b) {
+                if (b == kb)
+                    continue;
+
+                if (tile++ % n_threads == thread)
+                    relax_tile(kb, kb, b);
+
+                if (b < n_row_tiles && tile++ % n_threads == thread)
+                    relax_tile(kb, b, kb);
+            }
+
+            wait_all(barrier);
+
+            // Phase 3
+            tile = 0;
+            for (int sb = 0; sb < n_row_tiles; ++sb) {
+                if (sb == kb)
+                    continue;
+
+                for (int tb = 0; tb < n_tiles; ++tb) {
+                    if (tb == kb)
+                        continue;
+
+                    if (tile++ % n_threads == thread)
+                        relax_tile(kb, sb, tb);
+                }
+            }
+
+            wait_all(barrier);
+        }
+    });
+
+    sums.assign(n, 0);
+    for (const std::vector<int> & local_sums : thread_sums)
+        for (int s = 0; s < n; ++s)
+            sums[s] += local_sums[s];
+}
+
+// Sum of minimum paths from each important station to all the others
+// with Floyd on the distances matrix
+// Distances are initialized to a maximum path (n_stations - 1),
+// which is kept for stations not connected
+void sums_floyd(
+    const int n_important,
+    const std::vector<Edge> & edges,
+    const int n_stations,
+    const unsigned n_threads,
+    std::vector<int> & sums
+) {
+    DistanceMatrix matrix;
+    init_matrix(n_important, edges, n_stations, matrix);
+
+    floyd_tiled(matrix, n_threads, sums);
+}
+
+// Minimum paths from `source` to all nodes of the graph
+// with Dial's algorithm: nodes wait in buckets by distance,
+// and since weights are at most max_weight only max_weight + 1
+// buckets are needed, used in circular order
+// Nodes not connected keep INT_MAX
+// `buckets` is only a buffer, reused between calls to avoid allocations
+void search_from(
+    const Graph & graph,
+    const int source,
+    std::vector<int> & distance,
+    std::vector<std::vector<int>> & buckets
+) {
+    const int n_buckets = graph.max_weight + 1;
+
+    distance.assign(graph.n_nodes, INT_MAX);
+    buckets.resize(n_buckets);
+
+    distance[source] = 0;
+    buckets[0].push_back(source);
+
+    // Number of nodes waiting in the buckets
+    int n_waiting = 1;
+
+    for (int d = 0; n_waiting > 0; ++d) {
+        // Weights are at least 1,
+        // so nodes reached from this bucket go to other buckets
+        std::vector<int> & bucket = buckets[d % n_buckets];
+
+        while (!bucket.empty()) {
+            const int s = bucket.back();
+            bucket.pop_back();
+            --n_waiting;
+
+            // Skip nodes found again later with a shorter path
+            if (distance[s] != d)
+                continue;
+
+            for (int e = graph.offsets[s]; e < graph.offsets[s + 1]; ++e) {
+                const int t = graph.targets[e];
+                const int distance_t = d + graph.weights[e];
+
+                if (distance_t < distance[t]) {
+                    distance[t] = distance_t;
+                    buckets[distance_t % n_buckets].push_back(t);
+                    ++n_waiting;
+                }
+            }
+        }
+    }
+}
+
+// Sum of minimum paths from each important station to all the others
+// with a search from each station on the compressed sparse row graph
+// Stations not connected count as a maximum path (n_stations - 1),
+// as in sums_floyd
+// Sources are handed out to n_threads threads with an atomic counter,
+// each thread has its own buffers and writes the sums of its sources
+void sums_search(
+    const Graph & graph,
+    const int n_stations,
+    const unsigned n_threads,
+    std::vector<int> & sums
+) {
+    sums.assign(graph.n_nodes, 0);
+
+    std::atomic<int> next(0);
+
+    run_threads(n_threads, [&](unsigned) {
+        std::vector<int> distance;
+        std::vector<std::vector<int>> buckets;
+
+        for (;;) {
+            const int s = next.fetch_add(1, std::memory_order_relaxed);
+            if (s >= graph.n_nodes)
+                break;
+
+            search_from(graph, s, distance, buckets);
+
+            int sum = 0;
+            for (const int distance_t : distance)
+                sum += distance_t == INT_MAX ? n_stations - 1 : distance_t;
+
+            sums[s] = sum;
+        }
+    });
+}
+
+// Engines computing the minimum paths
+enum Engine {AUTO, SPARSE, DENSE};
+
+// Engine to use for a graph
+// Floyd costs n^3, with vector kernels and regular memory access,
+// searches cost n * (n + edges) with irregular access:
+// Floyd is chosen when the fraction of node pairs joined by an edge
+// is at least DENSE_THRESHOLD
+Engine choose_engine(
+    const Engine engine,
+    const int n_important,
+    const std::vector<Edge> & edges
+) {
+    if (engine != AUTO)
+        return engine;
+
+    // Edges can be repeated in different lines,
+    // the count is an upper bound of the actual edges
+    const double n_pairs = 0.5 * n_important * (n_important - 1);
+    const double density = n_pairs > 0 ? edges.size() / n_pairs : 1.0;
+
+    return density >= DENSE_THRESHOLD ? DENSE : SPARSE;
+}
+
+// Look for important station with minimum sum of
+// minimum paths with all other important stations
+// (There is no need to compute average)
+// Returns 0 if no sum is below the largest value
+int pick_station(
+    const std::vector<int> & sums,
+    const std::vector<int> & v_important,
+    const int n_stations
+) {
+    // Value of minimum sum of minimum paths
+    // is initialized with largest value,
+    // (n_stations - 1) for each path
+    int min_sum = (n_stations - 1) * static_cast<int>(v_important.size());
+
+    // Int to store important station with minimum average
+    int min_station = 0;
+
+    // This loops in order of increasing station number,
+    // thus in the case two stations can be solution,
+    // it will keep the smaller one
+    for (std::size_t s = 0; s < sums.size(); ++s) {
+        // Update minimum sum if needed
+        // and update minimum station accordingly
+        if (sums[s] < min_sum) {
+            min_sum = sums[s];
+            min_station = v_important[s];
+        }
+    }
+
+    return min_station;
+}
+
+// Sum of minimum paths from `source` to all the other nodes,
+// with the same search as search_from, stopped as soon as
+// the sum is known not to improve on `limit`
+// (a sum equal to limit only improves on it if `tie_improves`)
+// When the search reaches distance d, nodes not settled yet
+// are at least at min(d, max_path), which bounds the sum from below
+// Nodes not connected count as max_path
+// Returns -1 if the search was stopped
+int bounded_sum(
+    const Graph & graph,
+    const int source,
+    const int max_path,
+    const int limit,
+    const bool tie_improves,
+    std::vector<int> & distance,
+    std::vector<std::vector<int>> & buckets
+) {
+    const int n_buckets = graph.max_weight + 1;
+    const auto improves = [&](const long long sum) {
+        return sum < limit || (sum == limit && tie_improves);
+    };
+
+    distance.assign(graph.n_nodes, INT_MAX);
+    buckets.resize(n_buckets);
+
+    distance[source] = 0;
+    buckets[0].push_back(source);
+
+    // Number of nodes waiting in the buckets
+    int n_waiting = 1;
+
+    // Nodes whose minimum path is known, and the sum of those paths
+    int n_settled = 0;
+    long long settled_sum = 0;
+
+    for (int d = 0; n_waiting > 0; ++d) {
+        const long long bound =
+            settled_sum + static_cast<long long>(graph.n_nodes - n_settled) * std::min(d, max_path);
+
+        if (!improves(bound)) {
+            // Leave the buckets empty for the next search
+            for (std::vector<int> & bucket : buckets)
+                bucket.clear();
+
+            return -1;
+        }
+
+        std::vector<int> & bucket = buckets[d % n_buckets];
+
+        while (!bucket.empty()) {
+            const int s = bucket.back();
+            bucket.pop_back();
+            --n_waiting;
+
+            // Skip nodes found again later with a shorter path
+            if (distance[s] != d)
+                continue;
+
+            ++n_settled;
+            settled_sum += d;
+
+            for (int e = graph.offsets[s]; e < graph.offsets[s + 1]; ++e) {
+                const int t = graph.targets[e];
+                const int distance_t = d + graph.weights[e];
+
+                if (distance_t < distance[t]) {
+                    distance[t] = distance_t;
+                    buckets[distance_t % n_buckets].push_back(t);
+                    ++n_waiting;
+                }
+            }
+        }
+    }
+
+    const long long sum =
+        settled_sum + static_cast<long long>(graph.n_nodes - n_settled) * max_path;
+
+    return improves(sum) ? static_cast<int>(sum) : -1;
+}
+
+// Look for important station with minimum sum of
+// minimum paths with all other important stations,
+// without computing all the minimum paths (--pruned)
+// Candidates are tried by decreasing degree, since central stations
+// tend to have more neighbours: a good sum is found early,
+// and the searches of most other candidates stop soon
+// The result is the same as pick_station on all the sums:
+// ties go to the smaller station, and the sum has to be
+// below the largest value, (n_stations - 1) for each path
+int pick_station_pruned(
+    const Graph & graph,
+    const std::vector<int> & v_important,
+    const int n_stations
+) {
+    const int n_nodes = graph.n_nodes;
+
+    std::vector<int> candidates(n_nodes);
+    for (int s = 0; s < n_nodes; ++s)
+        candidates[s] = s;
+
+    std::stable_sort(
+        candidates.begin(),
+        candidates.end(),
+        [&](const int a, const int b) {
+            return graph.offsets[a + 1] - graph.offsets[a] >
+                graph.offsets[b + 1] - graph.offsets[b];
+        }
+    );
+
+    std::vector<int> distance;
+    std::vector<std::vector<int>> buckets;
+
+    // Best sum so far, and its node (n_nodes if none)
+    int min_sum = (n_stations - 1) * n_nodes;
+    int min_node = n_nodes;
+
+    for (const int s : candidates) {
+        // Important stations are ordered, a smaller node is a smaller station
+        const bool tie_improves = min_node < n_nodes && s < min_node;
+
+        const int sum = bounded_sum(
+            graph, s, n_stations - 1,
+            min_sum, tie_improves,
+            distance, buckets
+        );
+
+        if (sum >= 0) {
+            min_sum = sum;
+            min_node = s;
+        }
+    }
+
+    return min_node < n_nodes ? v_important[min_node] : 0;
+}
+
+int main(int argc, char * argv[])
 {
+    // Options:
+    //  --sparse     always compute minimum paths with a search
+    //               from each important station
+    //  --dense      always compute minimum paths with Floyd
+    //  --threads T  compute minimum paths with T threads (0 uses all cores)
+    //  --pruned     only compute the sums of minimum paths that can
+    //               still be the minimum (single thread)
+    // By default the engine is chosen from the density of each graph
+    Engine engine = AUTO;
+    unsigned n_threads = 1;
+    bool is_pruned = false;
+
+    for (int a = 1; a < argc; ++a) {
+        const std::string option = argv[a];
+
+        if (option == "--sparse") {
+            engine = SPARSE;
+        }
+        else if (option == "--dense") {
+            engine = DENSE;
+        }
+        else if (option == "--pruned") {
+            is_pruned = true;
+        }
+        else if (option == "--threads" && a + 1 < argc) {
+            n_threads = std::stoul(argv[++a]);
+            if (n_threads == 0)
+                n_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        else {
+            std::cerr << "Unknown option: " << option << "\n";
+            return 1;
+        }
+    }
+
     // Data structures to be used in tests
 
     // Vector of vectors to store lines of stations
@@ -18,27 +802,25 @@ int main()
     std::vector<std::vector<int>> lines;
     lines.reserve(MAX_N_LINES);
 
-    // Vector to store number of times 
+    // Vector to store number of times
     // each station is found
-    // (if count > 1 the station is important)
-    // (lines never repeat stations)
     std::vector<int> counts;
     counts.reserve(MAX_N_STATIONS);
+
     // Vector of important stations
     std::vector<int> v_important;
     v_important.reserve(MAX_N_IMPORTANT);
 
-    // Vector to store order of important station 
-    // (important_station = v_important[order_important - 1])          
-    // For non-important stations it will store 0
+    // Vector to store order of important station
     std::vector<int> order_important;
     order_important.reserve(MAX_N_STATIONS);
 
-    // Vector of vectors storing distances
-    // between important stations
-    // (dist[s])[t]
-    // s (t) index corresponds to v_important[s]
-    std::vector<std::vector<int>> dist;
+    // Edges and graph between important stations
+    std::vector<Edge> edges;
+    Graph graph;
+
+    // Sum of minimum paths from each important station
+    std::vector<int> sums;
 
     // Read input
 
@@ -49,7 +831,7 @@ int main()
     // Read parameters for each test
     for (int i = 0; i < n_tests; ++i) {
 
-        // Read total number of stations 
+        // Read total number of stations
         // and number of lines
         int n_stations;
         int n_lines;
@@ -60,170 +842,35 @@ int main()
         counts.clear();
         v_important.clear();
         order_important.clear();
-        dist.clear();
-        
+        edges.clear();
+
         // Vectors initialized with 0
         counts.resize(n_stations, 0);
         order_important.resize(n_stations, 0);
 
-        // Read stations in each line
-        for (int l = 0; l < n_lines; ++l) {
-            std::vector<int> stations_read;
-
-            for (;;) {
-                int station;
-                std::cin >> station;
-
-                if (!station)
-                    // When 0 is read it stops reading line
-                    // 0 is not introduced in the line vector
-                    break;
-                stations_read.push_back(station);
-
-                // Update count value for the station
-                ++counts[station - 1];
-            }
-
-            lines.push_back(stations_read);
-        }
-
-        int order = 0;
-        // Simplify graph by retaining only the important stations as nodes
-        for (int s = 0; s < n_stations; ++s) {
-            if (counts[s] > 1) {
-                const int station = s + 1;
-                v_important.push_back(station);
-                
-                // Update `order count`
-                ++order;
-                
-                // Store number for this station
-                order_important[s] = order;
+        read_lines(n_lines, lines, counts);
+        find_important(counts, v_important, order_important);
+        find_edges(lines, order_important, edges);
 
-                // Create a vector of distances
-                dist.push_back({});
-            }
-        }
-        
         // Number of important stations
-        const std::size_t n_important = v_important.size();
-
-        // In order to keep always a minimum value
-        // distances will be initialized to a 
-        // maximum path (n_stations - 1)
-        // (edges in full graph count always as 1)
-        for (std::size_t s = 0; s < n_important; ++s) {
-            (dist[s]).resize(n_important, n_stations - 1);
-
-            // Distance between the same station is zero
-            (dist[s])[s] = 0;
-        }
-
-        // Look for pairs of `consecutive` important stations in each line
-        for (std::size_t l = 0; l < lines.size(); ++l) {
-            // Count of edges between `consecutive` important stations
-            int steps = 0;
-
-            // Pair to store `consecutive` important stations
-            std::pair<int, int> found = {0, 0};
-
-            // Vector of stations in the line
-            // (Lines will remain constant till end of problem)
-            std::vector<int> & stations = lines[l];
-
-            // Loop over stations in each line
-            for (std::size_t s = 0; s < stations.size(); ++s) {
-                // Station number
-                const int station = stations[s];
-
-                // Check if station is important
-                if (order_important[station - 1] > 0) {
-                    // If the station is the first of the first pair
-                    if (found.first == 0) {
-                        found.first = station;
-                    }
-                    else {
-                        // The station is not the first one found,
-                        // thus it will be the second of a pair
-                        found.second = station;
-
-                        // Equivalent indeces in the `important` vector
-                        const int a = order_important[found.first - 1] - 1;
-                        const int b = order_important[found.second - 1] - 1;
-
-                        // Store distance for the completed pair
-                        // If a pair is repeated in a different line, 
-                        // the minimum path is kept
-                        if (steps < (dist[a])[b]) {
-                            // Graph is unordered
-                            (dist[a])[b] = steps;
-                            (dist[b])[a] = steps;
-                        }
-
-                        // The station found will be the first of a pair
-                        // (if it can be completed before ending the line)
-                        found.first = station;
-
-                        // Reinitialize steps for the next pair
-                        steps = 0;
-                    }
-                }
+        const int n_important = v_important.size();
 
-                // If a pair has already been started
-                // update steps before advancing to next station
-                if (found.first != 0)
-                    ++steps;
-            }
-        }
+        int min_station;
 
-        // Compute minimum paths between
-        // pairs of important stations
-        // Floyd is applied on simplified graph
-        for (std::size_t k = 0; k < n_important; ++k) {
-            for (std::size_t s = 0; s < n_important; ++s) {
-                for (std::size_t t = 0; t < n_important; ++t) {
-                    // Compare distance_st with sum of distances
-                    // to `intermediate` node k   
-                    const int distance_st = (dist[s])[t];
-
-                    // Skip when distance_st is already minimal
-                    if (distance_st > 1) {
-                        const int distance_skt = (dist[s])[k] + (dist[k])[t];
-                        if (distance_st > distance_skt)
-                            (dist[s])[t] = distance_skt;
-                    }
-                }
-            }
+        if (is_pruned) {
+            build_graph(n_important, edges, graph);
+            min_station = pick_station_pruned(graph, v_important, n_stations);
         }
-
-        // Look for important station with minimum sum of 
-        // minimum paths with all other important stations
-        // (There is no need to compute average)
-        // Value of minimum sum of minimum paths 
-        // is initialized with largest value,
-        // (n_stations - 1) for each path
-        int min_sum = (n_stations - 1) * n_important;
-
-        // Int to store important station with minimum average
-        int min_station = 0;
-  
-        // Compute sum of minimum paths for each important station
-        // This loops in order of increasing station number,
-        // thus in the case two stations can be solution,
-        // it will keep the smaller one
-        for (std::size_t s = 0; s < n_important; ++s) {
-            int sum = 0;
-
-            for (std::size_t t = 0; t < n_important; ++t) {
-                sum += (dist[s])[t];
+        else {
+            if (choose_engine(engine, n_important, edges) == SPARSE) {
+                build_graph(n_important, edges, graph);
+                sums_search(graph, n_stations, n_threads, sums);
             }
-
-            // Update minimum sum if needed
-            // and update minimum station accordingly
-            if (sum < min_sum) {
-                min_sum = sum;
-                min_station = v_important[s];
+            else {
+                sums_floyd(n_important, edges, n_stations, n_threads, sums);
             }
+
+            min_station = pick_station(sums, v_important, n_stations);
         }
 
         // Write output